@@ -23,9 +23,13 @@ typedef struct {
 	ChannelType type;
 	int (*setup)(HID_Report_ID report_id);
 	int (*get_hid_descriptor)(HID_Descriptor* hid_desc);
-	int (*send_report)(const ReportData* report);
-	Poll_Status (*get_report)(ReportData* report, bool apply_timeout,
-			long double timeout_val);
+	int (*send_report)(ReportData* report);
+	int (*send_reports)(ReportData* reports, uint num_reports);
+	Poll_Status (*get_report)(HID_Report_ID report_id, ReportData* report,
+			bool apply_timeout, long double timeout_val);
+	Poll_Status (*borrow_report)(HID_Report_ID report_id, ReportData** report,
+			bool apply_timeout, long double timeout_val);
+	void (*release_report)();
 	int (*teardown)();
 } Channel;
 
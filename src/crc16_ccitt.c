@@ -4,6 +4,10 @@
 
 #include "crc16_ccitt.h"
 
+#define SLICE_LEN 8
+
+static void _init_slice_tables();
+
 static const uint16_t ccittTable[256] =
 {
 	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
@@ -40,12 +44,50 @@ static const uint16_t ccittTable[256] =
 	0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0,
 };
 
+/*
+ * sliceTables[k][b] is the CRC of byte b followed by k zero bytes, so that
+ * SLICE_LEN bytes can be folded into the CRC with one lookup per byte and no
+ * dependency between the lookups. sliceTables[0] is ccittTable.
+ */
+static uint16_t sliceTables[SLICE_LEN][256];
+static pthread_once_t sliceTablesOnce = PTHREAD_ONCE_INIT;
+
 uint16_t calculate_crc16_ccitt(uint16_t seed, uint8_t *data,
 		size_t length) {
-    uint16_t crc = seed;
+	uint16_t crc = seed;
+	size_t i = 0;
+
+	if (length >= SLICE_LEN) {
+		pthread_once(&sliceTablesOnce, _init_slice_tables);
+
+		for (; i + SLICE_LEN <= length; i += SLICE_LEN) {
+			crc = sliceTables[7][data[i] ^ (crc >> 8)]
+					^ sliceTables[6][data[i + 1] ^ (crc & 0xFF)]
+					^ sliceTables[5][data[i + 2]]
+					^ sliceTables[4][data[i + 3]]
+					^ sliceTables[3][data[i + 4]]
+					^ sliceTables[2][data[i + 5]]
+					^ sliceTables[1][data[i + 6]]
+					^ sliceTables[0][data[i + 7]];
+		}
+	}
 
-	for (int i=0; i < length; i++) {
+	for (; i < length; i++) {
 		crc = (crc << 8) ^ ccittTable[(crc >> 8) ^(data[i] & 0xFF)];
 	}
 	return crc;
 }
+
+static void _init_slice_tables()
+{
+	for (int b = 0; b < 256; b++) {
+		sliceTables[0][b] = ccittTable[b];
+	}
+
+	for (int k = 1; k < SLICE_LEN; k++) {
+		for (int b = 0; b < 256; b++) {
+			uint16_t prev = sliceTables[k - 1][b];
+			sliceTables[k][b] = (prev << 8) ^ ccittTable[prev >> 8];
+		}
+	}
+}
@@ -7,6 +7,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <pthread.h>
 
 extern uint16_t calculate_crc16_ccitt(uint16_t seed, uint8_t *data,
 		size_t length);
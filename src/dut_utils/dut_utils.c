@@ -9,6 +9,31 @@
 
 #define MAX_NUM_OF_BYTES_PER_SENSOR  8
 
+#define MAX_FLASH_FILE_REWRITES 3
+
+/*
+ * Returned by _flash_file_diff_write() when the flash file could not be
+ * reopened for the fallback, so its handle must not be used anymore.
+ */
+#define FLASH_FILE_HANDLE_LOST (EXIT_FAILURE + 1)
+
+/*
+ * How often the flash journal is saved while a flash file is written.
+ */
+#define FLASH_JOURNAL_INTERVAL (16 * 1024)
+
+/*
+ * Tracks how much of an image the device has acknowledged while one
+ * FILE_WRITE sequence writes it from 'start_len' onwards.
+ */
+typedef struct {
+	const Flash_Journal_Key* journal_key;
+	size_t image_len;
+	uint32_t start_len;
+	uint32_t saved_len;
+	uint32_t* written_len;
+} Flash_Write_Progress;
+
 char* FW_LOADER_NAMES[] = {
 	[FLASH_LOADER_NONE]                     = "No active/valid flash loader",
 	[FLASH_LOADER_TP_PROGRAMMER_IMAGE]      = "TP Programmer Image",
@@ -19,15 +44,31 @@ char* FW_LOADER_NAMES[] = {
 static DUT_State active_dut_state = DUT_STATE_DEFAULT;
 static Flash_Loader active_flash_loader = FLASH_LOADER_NONE;
 static struct timeval aux_mcu_active_start_time;
+static bool use_diff_write = false;
+static bool use_resume = true;
 
 static int _enter_flash_loader(const Flash_Loader_Options* options);
 static int _erase_config_file(uint8_t config_file_num);
 static int _exit_flash_loader();
 static int _flash_file_close(uint8_t file_handle);
+static int _flash_file_crc(uint8_t file_handle, uint32_t len, uint16_t* crc);
+static int _flash_file_diff_write(uint8_t file_num, uint8_t* file_handle,
+		ByteData* image);
 static int _flash_file_erase(uint8_t file_handle);
+static int _flash_file_read_range(uint8_t file_handle, uint32_t offset,
+		uint8_t* data, size_t len);
+static int _flash_file_seek(uint8_t file_handle, uint32_t offset);
+static int _flash_file_size(uint8_t file_handle, uint32_t* size);
 static int _flash_file_open(uint8_t file_num, uint8_t* file_handle);
-static int _flash_file_write(uint8_t file_handle, ByteData* data);
+static int _flash_file_read(uint8_t file_handle, uint8_t* data, size_t len);
+static int _flash_file_write(uint8_t file_handle, ByteData* data,
+		PIP_Write_Progress_Func progress, void* progress_context);
+static int _flash_file_write_journaled(uint8_t file_handle, ByteData* image,
+		uint32_t* written_len, const Flash_Journal_Key* journal_key);
+static void _flash_file_write_progress(size_t acked_len, void* context);
 static DUT_State _get_dut_state_from_fw_sys_mode(PIP3_App_Sys_Mode sys_mode);
+static int _get_flash_journal_key(uint8_t file_num, const ByteData* image,
+		Flash_Journal_Key* key);
 static int _set_dut_state_aux_mcu_fw_programmer_img();
 static int _set_dut_state_aux_mcu_fw_utility_img();
 static int _set_dut_state_tp_bl_exec();
@@ -192,6 +233,115 @@ RETURN:
 	return rc;
 }
 
+/*
+ * Copies the whole flash file to 'fd'. The output is mapped and each
+ * FILE_READ response is copied straight into it. Outputs that cannot be
+ * mapped, such as pipes, are written in one go once the file has been read.
+ */
+int read_dut_flash_file(uint8_t file_num, int fd,
+		const Flash_Loader_Options* loader_options)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	int rc = EXIT_FAILURE;
+	int cmd_rc = EXIT_FAILURE;
+	uint8_t file_handle;
+	bool file_open = false;
+	uint32_t file_size = 0;
+	uint8_t* file_data = MAP_FAILED;
+	bool file_data_mapped = false;
+	size_t num_written = 0;
+	struct timespec start_time;
+	struct timespec end_time;
+
+	cmd_rc = _enter_flash_loader(loader_options);
+	if (cmd_rc != EXIT_SUCCESS) {
+		rc = cmd_rc;
+		goto RETURN;
+	}
+
+	cmd_rc = _flash_file_open(file_num, &file_handle);
+	if (cmd_rc != EXIT_SUCCESS) {
+		rc = cmd_rc;
+		goto RETURN;
+	} else {
+		output(DEBUG, "Opened the flash file ID %u.\n", file_num);
+		file_open = true;
+	}
+
+	cmd_rc = _flash_file_size(file_handle, &file_size);
+	if (cmd_rc != EXIT_SUCCESS) {
+		rc = cmd_rc;
+		goto RETURN;
+	} else if (file_size == 0) {
+		output(INFO, "The flash file ID %u is empty.\n", file_num);
+		rc = EXIT_SUCCESS;
+		goto RETURN;
+	}
+
+	if (0 == ftruncate(fd, file_size)) {
+		file_data = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+				fd, 0);
+	}
+	if (file_data != MAP_FAILED) {
+		file_data_mapped = true;
+	} else {
+		output(DEBUG,
+				"%s: The output cannot be mapped, so it will be written "
+				"instead. %s [%d].\n",
+				__func__, strerror(errno), errno);
+		file_data = malloc(file_size);
+		if (file_data == NULL) {
+			output(ERROR, "%s: Memory allocation failed.\n", __func__);
+			goto RETURN;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+	cmd_rc = _flash_file_read(file_handle, file_data, file_size);
+	if (cmd_rc != EXIT_SUCCESS) {
+		rc = cmd_rc;
+		goto RETURN;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+	while (!file_data_mapped && num_written < file_size) {
+		ssize_t num_bytes_written = write(fd, &file_data[num_written],
+				file_size - num_written);
+		if (num_bytes_written < 0 && errno != EINTR) {
+			output(ERROR, "%s: Failed to write the flash file ID %u. %s [%d].\n",
+					__func__, file_num, strerror(errno), errno);
+			goto RETURN;
+		} else if (num_bytes_written > 0) {
+			num_written += num_bytes_written;
+		}
+	}
+
+	output(INFO, "Read %u bytes from the flash file ID %u in %.1Lf ms.\n",
+			file_size, file_num, get_timespec_diff_ms(&start_time, &end_time));
+	rc = EXIT_SUCCESS;
+
+RETURN:
+	if (file_data_mapped) {
+		munmap(file_data, file_size);
+	} else if (file_data != MAP_FAILED) {
+		free(file_data);
+	}
+
+	if (file_open) {
+		cmd_rc = _flash_file_close(file_handle);
+		if (cmd_rc != EXIT_SUCCESS) {
+			rc = cmd_rc;
+		}
+	}
+
+	cmd_rc = _exit_flash_loader();
+	if (cmd_rc != EXIT_SUCCESS) {
+		rc = cmd_rc;
+	}
+
+	return rc;
+}
+
 int read_dut_fw_bin_header(FW_Bin_Header* bin_header)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
@@ -250,6 +400,16 @@ RETURN:
 	return rc;
 }
 
+void set_dut_flash_diff_write(bool enable)
+{
+	use_diff_write = enable;
+}
+
+void set_dut_flash_resume(bool enable)
+{
+	use_resume = enable;
+}
+
 int set_dut_state(DUT_State target_state)
 {
 	switch (target_state) {
@@ -307,6 +467,14 @@ int write_image_to_dut_flash_file(uint8_t file_num, ByteData* image,
 	int cmd_rc = EXIT_FAILURE;
 	uint8_t file_handle;
 	bool file_open = false;
+	bool image_written = false;
+	bool file_crc_supported;
+	uint16_t file_crc;
+	uint16_t image_crc;
+	uint32_t file_size;
+	Flash_Journal_Key journal_key;
+	bool use_journal = false;
+	uint32_t written_len = 0;
 
 	if (file_nums_to_erase != NULL && file_nums_to_erase->data == NULL) {
 		output(ERROR,
@@ -338,12 +506,77 @@ int write_image_to_dut_flash_file(uint8_t file_num, ByteData* image,
 		file_open = true;
 	}
 
-	cmd_rc = _flash_file_erase(file_handle);
-	if (cmd_rc != EXIT_SUCCESS) {
-		rc = cmd_rc;
+	/*
+	 * The device calculates the CRC of the file itself, so comparing it with
+	 * the CRC of the image costs one command regardless of the image size.
+	 * The CRC only covers the length of the image, so the file size has to
+	 * match as well before the write is skipped.
+	 */
+	image_crc = calculate_crc16_ccitt(0xFFFF, image->data, image->len);
+	file_crc_supported = (EXIT_SUCCESS
+			== _flash_file_crc(file_handle, image->len, &file_crc));
+	if (!file_crc_supported) {
+		output(INFO,
+				"The %s does not support the FILE_CRC command, so the flash "
+				"file will not be verified.\n",
+				FW_LOADER_NAMES[active_flash_loader]);
+	} else if (file_crc == image_crc
+			&& EXIT_SUCCESS == _flash_file_size(file_handle, &file_size)
+			&& file_size == image->len) {
+		output(INFO,
+				"The flash file ID %u already matches the image (CRC %04X), so "
+				"it will not be rewritten.\n",
+				file_num, image_crc);
+		rc = EXIT_SUCCESS;
 		goto RETURN;
 	}
 
+	/*
+	 * A journal left by an interrupted write of the same image is only
+	 * trusted once the device confirms that the part it claims was written
+	 * matches the image.
+	 */
+	use_journal = use_resume && file_crc_supported && EXIT_SUCCESS
+			== _get_flash_journal_key(file_num, image, &journal_key);
+	if (use_journal && EXIT_SUCCESS
+			== load_flash_journal(&journal_key, &written_len)
+			&& written_len > 0) {
+		if (EXIT_SUCCESS == _flash_file_crc(file_handle, written_len,
+						&file_crc)
+				&& file_crc == calculate_crc16_ccitt(0xFFFF, image->data,
+						written_len)
+				&& EXIT_SUCCESS == _flash_file_seek(file_handle, written_len)) {
+			output(INFO,
+					"Resuming the write of the flash file ID %u at byte %u of "
+					"%lu.\n",
+					file_num, written_len, image->len);
+		} else {
+			output(INFO,
+					"The flash file ID %u does not match its journal, so it "
+					"will be rewritten.\n",
+					file_num);
+			written_len = 0;
+		}
+	}
+
+	if (use_diff_write && written_len == 0) {
+		rc = _flash_file_diff_write(file_num, &file_handle, image);
+		image_written = (rc == EXIT_SUCCESS);
+		if (rc == FLASH_FILE_HANDLE_LOST) {
+			file_open = false;
+			rc = EXIT_FAILURE;
+			goto RETURN;
+		}
+	}
+
+	if (!image_written && written_len == 0) {
+		cmd_rc = _flash_file_erase(file_handle);
+		if (cmd_rc != EXIT_SUCCESS) {
+			rc = cmd_rc;
+			goto RETURN;
+		}
+	}
+
 	for (int i = 0; file_nums_to_erase != NULL && i < file_nums_to_erase->len;
 			i++) {
 		cmd_rc = _erase_config_file(file_nums_to_erase->data[i]);
@@ -353,7 +586,64 @@ int write_image_to_dut_flash_file(uint8_t file_num, ByteData* image,
 		}
 	}
 
-	rc = _flash_file_write(file_handle, image);
+	/*
+	 * A failed pipelined PIP3 FILE_WRITE leaves the device file pointer past
+	 * the point of failure, so the file is reopened and rewritten with the
+	 * reduced window. When the write is journaled it carries on from the last
+	 * acknowledged byte, otherwise the file is erased and rewritten from the
+	 * start.
+	 */
+	for (int attempt = 0; !image_written; attempt++) {
+		uint write_window = get_pip3_file_write_window();
+
+		rc = _flash_file_write_journaled(file_handle, image, &written_len,
+				use_journal ? &journal_key : NULL);
+		if (rc == EXIT_SUCCESS || attempt >= MAX_FLASH_FILE_REWRITES
+				|| get_pip3_file_write_window() >= write_window) {
+			break;
+		}
+
+		output(WARNING, "Rewriting the flash file ID %u.\n", file_num);
+		record_pip_cmd_retries(PIP_PROTOCOL_PIP3, PIP3_CMD_ID_FILE_WRITE, 1);
+		file_open = false;
+		cmd_rc = _flash_file_close(file_handle);
+		if (cmd_rc == EXIT_SUCCESS) {
+			cmd_rc = _flash_file_open(file_num, &file_handle);
+		}
+		if (cmd_rc != EXIT_SUCCESS) {
+			rc = cmd_rc;
+			goto RETURN;
+		}
+		file_open = true;
+
+		if (written_len > 0) {
+			cmd_rc = _flash_file_seek(file_handle, written_len);
+		} else {
+			cmd_rc = _flash_file_erase(file_handle);
+		}
+		if (cmd_rc != EXIT_SUCCESS) {
+			rc = cmd_rc;
+			goto RETURN;
+		}
+	}
+
+	if (rc == EXIT_SUCCESS && use_journal) {
+		delete_flash_journal(&journal_key);
+	}
+
+	if (rc == EXIT_SUCCESS && file_crc_supported) {
+		cmd_rc = _flash_file_crc(file_handle, image->len, &file_crc);
+		if (cmd_rc != EXIT_SUCCESS || file_crc != image_crc) {
+			output(ERROR,
+					"%s: The flash file ID %u does not match the image after "
+					"being written (CRC %04X, expected %04X).\n",
+					__func__, file_num, file_crc, image_crc);
+			rc = EXIT_FAILURE;
+		} else {
+			output(DEBUG, "Verified the flash file ID %u (CRC %04X).\n",
+					file_num, file_crc);
+		}
+	}
 
 RETURN:
 	if (file_open) {
@@ -543,6 +833,182 @@ static int _flash_file_close(uint8_t file_handle)
 	return rc;
 }
 
+/*
+ * Gets the CRC16-CCITT of the first 'len' bytes of the flash file, as
+ * calculated by the device.
+ */
+static int _flash_file_crc(uint8_t file_handle, uint32_t len, uint16_t* crc)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	int rc = EXIT_FAILURE;
+
+	if (FLASH_LOADER_NONE == active_flash_loader) {
+		output(ERROR, "%s: %s.\n",
+				__func__, FW_LOADER_NAMES[active_flash_loader]);
+		rc = EXIT_FAILURE;
+	} else if (FLASH_LOADER_TP_PROGRAMMER_IMAGE == active_flash_loader
+			|| FLASH_LOADER_AUX_MCU_PROGRAMMER_IMAGE == active_flash_loader) {
+		PIP3_Rsp_Payload_FileIOCTL_FileCRC file_ioctl_crc_rsp;
+		rc = do_pip3_file_ioctl_crc_cmd(0x00, file_handle, 0, len,
+				&file_ioctl_crc_rsp);
+		*crc = (file_ioctl_crc_rsp.crc_msb << 8) | file_ioctl_crc_rsp.crc_lsb;
+	} else if (FLASH_LOADER_PIP2_ROM_BL == active_flash_loader) {
+		PIP2_Rsp_Payload_FileIOCTL_FileCRC file_ioctl_crc_rsp;
+		rc = do_pip2_file_ioctl_crc_cmd(0x00, file_handle, 0, len,
+				&file_ioctl_crc_rsp);
+		*crc = (file_ioctl_crc_rsp.crc_msb << 8) | file_ioctl_crc_rsp.crc_lsb;
+	} else {
+		output(ERROR,
+				"%s: Unexpected/unsupported 'Flash_Loader' enum value (%d).\n",
+				__func__, active_flash_loader);
+		rc = EXIT_FAILURE;
+	}
+
+	return rc;
+}
+
+/*
+ * Reads the flash file back and only rewrites the parts that differ from the
+ * image, without erasing the file. Each rewritten range is read back again to
+ * make sure the flash took the new data. Any failure leaves the file reopened
+ * so that the caller can fall back to erasing and rewriting all of it, or
+ * returns FLASH_FILE_HANDLE_LOST if it could not be reopened. A file whose
+ * size differs from the image is never diffed, since a longer file would keep
+ * its stale tail.
+ *
+ * The flash loaders do not report their sector size, so the image is compared
+ * in blocks of one FILE_READ. This does not have to line up with the flash
+ * program or erase unit: a range the device cannot program in place fails the
+ * read back check and falls back to the full rewrite.
+ */
+static int _flash_file_diff_write(uint8_t file_num, uint8_t* file_handle,
+		ByteData* image)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	uint8_t* flash_data = NULL;
+	uint32_t file_size;
+	size_t block_len = get_pip3_file_read_max_len();
+	size_t num_bytes_rewritten = 0;
+	uint num_ranges = 0;
+	struct timespec start_time;
+	struct timespec read_end_time;
+	struct timespec end_time;
+	int rc = EXIT_FAILURE;
+
+	if (FLASH_LOADER_TP_PROGRAMMER_IMAGE != active_flash_loader
+			&& FLASH_LOADER_AUX_MCU_PROGRAMMER_IMAGE != active_flash_loader) {
+		output(INFO,
+				"Differential flash writes are not supported by the %s.\n",
+				FW_LOADER_NAMES[active_flash_loader]);
+		return EXIT_FAILURE;
+	}
+
+	if (EXIT_SUCCESS != _flash_file_size(*file_handle, &file_size)) {
+		output(INFO,
+				"Unable to get the size of the flash file ID %u, so it will "
+				"not be written differentially.\n",
+				file_num);
+		return EXIT_FAILURE;
+	} else if (file_size != image->len) {
+		output(INFO,
+				"The flash file ID %u is %u bytes but the image is %lu bytes, "
+				"so it will not be written differentially.\n",
+				file_num, file_size, image->len);
+		return EXIT_FAILURE;
+	}
+
+	flash_data = malloc(image->len);
+	if (flash_data == NULL) {
+		output(ERROR, "%s: Memory allocation failed.\n", __func__);
+		return EXIT_FAILURE;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+	if (EXIT_SUCCESS != _flash_file_read_range(*file_handle, 0, flash_data,
+			image->len)) {
+		goto RETURN;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &read_end_time);
+
+	for (size_t start = 0; start < image->len; ) {
+		size_t end;
+		size_t len;
+
+		if (0 == memcmp(&flash_data[start], &image->data[start],
+				(image->len - start < block_len)
+						? image->len - start : block_len)) {
+			start += block_len;
+			continue;
+		}
+
+		for (end = start + block_len; end < image->len; end += block_len) {
+			len = (image->len - end < block_len) ? image->len - end : block_len;
+			if (0 == memcmp(&flash_data[end], &image->data[end], len)) {
+				break;
+			}
+		}
+		if (end > image->len) {
+			end = image->len;
+		}
+		len = end - start;
+
+		PIP3_Rsp_Payload_FileIOCTL_SeekFilePointers seek_rsp;
+		ByteData range = { .data = &image->data[start], .len = len };
+		if (EXIT_SUCCESS != do_pip3_file_ioctl_seek_file_pointers_cmd(0x00,
+						*file_handle, start, start, &seek_rsp)
+				|| EXIT_SUCCESS != _flash_file_write(*file_handle, &range,
+						NULL, NULL)
+				|| EXIT_SUCCESS != _flash_file_read_range(*file_handle, start,
+						&flash_data[start], len)
+				|| 0 != memcmp(&flash_data[start], range.data, len)) {
+			output(WARNING,
+					"Failed to rewrite bytes %lu to %lu of the flash file ID "
+					"%u in place.\n",
+					start, end - 1, file_num);
+			goto RETURN;
+		}
+
+		num_bytes_rewritten += len;
+		num_ranges++;
+		start = end;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+	output(INFO,
+			"Flash file ID %u: %lu of %lu bytes were unchanged and skipped, "
+			"%lu bytes in %u ranges were rewritten.\n",
+			file_num, image->len - num_bytes_rewritten, image->len,
+			num_bytes_rewritten, num_ranges);
+	output(INFO,
+			"Reading back the flash file took %.1Lf ms and rewriting it took "
+			"%.1Lf ms.\n",
+			get_timespec_diff_ms(&start_time, &read_end_time),
+			get_timespec_diff_ms(&read_end_time, &end_time));
+	if (num_bytes_rewritten > 0) {
+		long double ms_per_byte = get_timespec_diff_ms(&read_end_time,
+				&end_time) / num_bytes_rewritten;
+		output(INFO, "Estimated time saved: %.1Lf ms.\n",
+				ms_per_byte * (image->len - num_bytes_rewritten)
+				- get_timespec_diff_ms(&start_time, &read_end_time));
+	}
+	rc = EXIT_SUCCESS;
+
+RETURN:
+	free(flash_data);
+	if (rc != EXIT_SUCCESS) {
+		output(WARNING,
+				"Falling back to erasing and rewriting the flash file ID %u.\n",
+				file_num);
+		if (EXIT_SUCCESS != _flash_file_close(*file_handle)
+				|| EXIT_SUCCESS != _flash_file_open(file_num, file_handle)) {
+			output(ERROR, "%s: Failed to reopen the flash file ID %u.\n",
+					__func__, file_num);
+			rc = FLASH_FILE_HANDLE_LOST;
+		}
+	}
+	return rc;
+}
+
 static int _flash_file_erase(uint8_t file_handle)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
@@ -599,9 +1065,112 @@ static int _flash_file_open(uint8_t file_num, uint8_t* file_handle)
 	return rc;
 }
 
-static int _flash_file_write(uint8_t file_handle, ByteData* data)
+/*
+ * Reads 'len' bytes from the read pointer of the flash file. Each FILE_READ
+ * asks for as much as fits in a single response.
+ */
+static int _flash_file_read(uint8_t file_handle, uint8_t* data, size_t len)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	size_t num_read = 0;
+	int rc = EXIT_SUCCESS;
+
+	if (FLASH_LOADER_NONE == active_flash_loader) {
+		output(ERROR, "%s: %s.\n",
+				__func__, FW_LOADER_NAMES[active_flash_loader]);
+		rc = EXIT_FAILURE;
+	} else if (FLASH_LOADER_TP_PROGRAMMER_IMAGE == active_flash_loader
+			|| FLASH_LOADER_AUX_MCU_PROGRAMMER_IMAGE == active_flash_loader) {
+		PIP3_Rsp_Payload_FileRead file_read_rsp;
+		size_t max_read_len = get_pip3_file_read_max_len();
+
+		while (rc == EXIT_SUCCESS && num_read < len) {
+			uint16_t read_len = (len - num_read < max_read_len)
+					? len - num_read : max_read_len;
+
+			file_read_rsp.data = &data[num_read];
+			rc = do_pip3_file_read_cmd(0x00, file_handle, read_len,
+					&file_read_rsp,
+					read_len + sizeof(PIP3_Rsp_Payload_FileRead));
+			num_read += read_len;
+		}
+	} else if (FLASH_LOADER_PIP2_ROM_BL == active_flash_loader) {
+		PIP2_Rsp_Payload_FileRead file_read_rsp;
+
+		while (rc == EXIT_SUCCESS && num_read < len) {
+			uint16_t read_len = (len - num_read < PIP2_FILE_READ_MAX_LEN)
+					? len - num_read : PIP2_FILE_READ_MAX_LEN;
+
+			file_read_rsp.data = &data[num_read];
+			rc = do_pip2_file_read_cmd(0x00, file_handle, read_len,
+					&file_read_rsp,
+					read_len + sizeof(PIP2_Rsp_Payload_FileRead));
+			num_read += read_len;
+		}
+	} else {
+		output(ERROR,
+				"%s: Unexpected/unsupported 'Flash_Loader' enum value (%d).\n",
+				__func__, active_flash_loader);
+		rc = EXIT_FAILURE;
+	}
+
+	return rc;
+}
+
+/*
+ * Only supported by the PIP3 flash loaders.
+ */
+static int _flash_file_read_range(uint8_t file_handle, uint32_t offset,
+		uint8_t* data, size_t len)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	PIP3_Rsp_Payload_FileIOCTL_SeekFilePointers seek_rsp;
+	int rc;
+
+	rc = do_pip3_file_ioctl_seek_file_pointers_cmd(0x00, file_handle, offset,
+			offset, &seek_rsp);
+	if (rc == EXIT_SUCCESS) {
+		rc = _flash_file_read(file_handle, data, len);
+	}
+
+	return rc;
+}
+
+/*
+ * Moves both the read and the write pointer of the flash file.
+ */
+static int _flash_file_seek(uint8_t file_handle, uint32_t offset)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	int rc = EXIT_FAILURE;
+
+	if (FLASH_LOADER_NONE == active_flash_loader) {
+		output(ERROR, "%s: %s.\n",
+				__func__, FW_LOADER_NAMES[active_flash_loader]);
+		rc = EXIT_FAILURE;
+	} else if (FLASH_LOADER_TP_PROGRAMMER_IMAGE == active_flash_loader
+			|| FLASH_LOADER_AUX_MCU_PROGRAMMER_IMAGE == active_flash_loader) {
+		PIP3_Rsp_Payload_FileIOCTL_SeekFilePointers seek_rsp;
+		rc = do_pip3_file_ioctl_seek_file_pointers_cmd(0x00, file_handle,
+				offset, offset, &seek_rsp);
+	} else if (FLASH_LOADER_PIP2_ROM_BL == active_flash_loader) {
+		PIP2_Rsp_Payload_FileIOCTL_SeekFilePointers seek_rsp;
+		rc = do_pip2_file_ioctl_seek_file_pointers_cmd(0x00, file_handle,
+				offset, offset, &seek_rsp);
+	} else {
+		output(ERROR,
+				"%s: Unexpected/unsupported 'Flash_Loader' enum value (%d).\n",
+				__func__, active_flash_loader);
+		rc = EXIT_FAILURE;
+	}
+
+	return rc;
+}
+
+static int _flash_file_size(uint8_t file_handle, uint32_t* size)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
+	const uint8_t* file_size = NULL;
 	int rc = EXIT_FAILURE;
 
 	if (FLASH_LOADER_NONE == active_flash_loader) {
@@ -610,9 +1179,48 @@ static int _flash_file_write(uint8_t file_handle, ByteData* data)
 		rc = EXIT_FAILURE;
 	} else if (FLASH_LOADER_TP_PROGRAMMER_IMAGE == active_flash_loader
 			|| FLASH_LOADER_AUX_MCU_PROGRAMMER_IMAGE == active_flash_loader) {
+		PIP3_Rsp_Payload_FileIOCTL_FileStats file_ioctl_stats_rsp;
+		rc = do_pip3_file_ioctl_file_stats_cmd(0x00, file_handle,
+				&file_ioctl_stats_rsp);
+		file_size = file_ioctl_stats_rsp.file_size;
+		*size = ((uint32_t) file_size[3] << 24) | (file_size[2] << 16)
+				| (file_size[1] << 8) | file_size[0];
+	} else if (FLASH_LOADER_PIP2_ROM_BL == active_flash_loader) {
+		PIP2_Rsp_Payload_FileIOCTL_FileStats file_ioctl_stats_rsp;
+		rc = do_pip2_file_ioctl_file_stats_cmd(0x00, file_handle,
+				&file_ioctl_stats_rsp);
+		file_size = file_ioctl_stats_rsp.file_size;
+		*size = ((uint32_t) file_size[3] << 24) | (file_size[2] << 16)
+				| (file_size[1] << 8) | file_size[0];
+	} else {
+		output(ERROR,
+				"%s: Unexpected/unsupported 'Flash_Loader' enum value (%d).\n",
+				__func__, active_flash_loader);
+		rc = EXIT_FAILURE;
+	}
+
+	return rc;
+}
+
+static int _flash_file_write(uint8_t file_handle, ByteData* data,
+		PIP_Write_Progress_Func progress, void* progress_context)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	int rc = EXIT_FAILURE;
+
+	if (FLASH_LOADER_NONE == active_flash_loader) {
+		output(ERROR, "%s: %s.\n",
+				__func__, FW_LOADER_NAMES[active_flash_loader]);
+		rc = EXIT_FAILURE;
+	} else if (FLASH_LOADER_TP_PROGRAMMER_IMAGE == active_flash_loader
+			|| FLASH_LOADER_AUX_MCU_PROGRAMMER_IMAGE == active_flash_loader) {
+		set_pip3_file_write_progress(progress, progress_context);
 		rc = do_pip3_file_write_cmd(0x00, file_handle, data);
+		set_pip3_file_write_progress(NULL, NULL);
 	} else if (FLASH_LOADER_PIP2_ROM_BL == active_flash_loader) {
+		set_pip2_file_write_progress(progress, progress_context);
 		rc = do_pip2_file_write_cmd(0x00, file_handle, data);
+		set_pip2_file_write_progress(NULL, NULL);
 	} else {
 		output(ERROR,
 				"%s: Unexpected/unsupported 'Flash_Loader' enum value (%d).\n",
@@ -623,6 +1231,52 @@ static int _flash_file_write(uint8_t file_handle, ByteData* data)
 	return rc;
 }
 
+/*
+ * Writes the image from 'written_len' onwards with one FILE_WRITE sequence.
+ * With a journal key, 'written_len' follows the writes as the device
+ * acknowledges them and the journal is saved every FLASH_JOURNAL_INTERVAL
+ * bytes, so a failed write can carry on from the last acknowledged byte.
+ */
+static int _flash_file_write_journaled(uint8_t file_handle, ByteData* image,
+		uint32_t* written_len, const Flash_Journal_Key* journal_key)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	Flash_Write_Progress progress = {
+			.journal_key = journal_key,
+			.image_len   = image->len,
+			.start_len   = *written_len,
+			.saved_len   = *written_len,
+			.written_len = written_len
+	};
+	ByteData rest = {
+			.data = &image->data[*written_len],
+			.len  = image->len - *written_len
+	};
+	int rc;
+
+	rc = _flash_file_write(file_handle, &rest,
+			(journal_key != NULL) ? _flash_file_write_progress : NULL,
+			&progress);
+	if (rc == EXIT_SUCCESS) {
+		*written_len = image->len;
+	}
+
+	return rc;
+}
+
+static void _flash_file_write_progress(size_t acked_len, void* context)
+{
+	Flash_Write_Progress* progress = (Flash_Write_Progress*) context;
+
+	*progress->written_len = progress->start_len + acked_len;
+	if (*progress->written_len < progress->image_len
+			&& *progress->written_len - progress->saved_len
+				>= FLASH_JOURNAL_INTERVAL) {
+		save_flash_journal(progress->journal_key, *progress->written_len);
+		progress->saved_len = *progress->written_len;
+	}
+}
+
 static DUT_State _get_dut_state_from_fw_sys_mode(PIP3_App_Sys_Mode sys_mode)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
@@ -657,6 +1311,33 @@ static DUT_State _get_dut_state_from_fw_sys_mode(PIP3_App_Sys_Mode sys_mode)
 	return dut_state;
 }
 
+static int _get_flash_journal_key(uint8_t file_num, const ByteData* image,
+		Flash_Journal_Key* key)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	memset(key, 0, sizeof(*key));
+	key->file_num = file_num;
+	key->image_len = image->len;
+	key->image_hash = calculate_flash_journal_hash(image->data, image->len);
+
+	if (FLASH_LOADER_TP_PROGRAMMER_IMAGE == active_flash_loader
+			|| FLASH_LOADER_AUX_MCU_PROGRAMMER_IMAGE == active_flash_loader) {
+		PIP3_Rsp_Payload_Version version_rsp;
+		if (EXIT_SUCCESS != do_pip3_version_cmd(0x00, &version_rsp)) {
+			output(DEBUG,
+					"%s: Unable to get the silicon UID, so the write will not "
+					"be journaled.\n",
+					__func__);
+			return EXIT_FAILURE;
+		}
+		memcpy(key->device_id, version_rsp.silicon_uid,
+				sizeof(key->device_id));
+	}
+
+	return EXIT_SUCCESS;
+}
+
 #define AUX_MCU_MAX_WAIT_TO_ACTIVATE_SECONDS 5
 
 static int _set_dut_state_aux_mcu()
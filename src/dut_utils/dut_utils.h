@@ -5,7 +5,9 @@
 #ifndef PTLIB_DUT_UTILS_DUT_UTILS_H_
 #define PTLIB_DUT_UTILS_DUT_UTILS_H_
 
+#include <sys/mman.h>
 #include "dut_state.h"
+#include "flash_journal.h"
 #include "../dut_driver.h"
 #include "../pip/fw_bin_header.h"
 #include "../pip/pip2.h"
@@ -33,7 +35,11 @@ extern int calibrate_dut();
 extern int do_dut_fw_self_test(PIP3_Self_Test_ID self_test_id,
 		int output_format_id, ByteData* cmd_params, bool signed_data,
 		bool length_known, FW_Self_Test_Results* results);
+extern int read_dut_flash_file(uint8_t file_num, int fd,
+		const Flash_Loader_Options* loader_options);
 extern int read_dut_fw_bin_header(FW_Bin_Header* bin_header);
+extern void set_dut_flash_diff_write(bool enable);
+extern void set_dut_flash_resume(bool enable);
 extern int set_dut_state(DUT_State target_state);
 extern int write_image_to_dut_flash_file(uint8_t file_num, ByteData* image,
 		const ByteData* file_nums_to_erase,
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#include "flash_journal.h"
+
+#define FLASH_JOURNAL_MAGIC   0x4A465450
+#define FLASH_JOURNAL_VERSION 1
+#define FLASH_JOURNAL_FILE_MAX_STRLEN 80
+
+#define FNV1A_64_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV1A_64_PRIME        0x00000100000001B3ULL
+
+static const Cache_Record_Type FLASH_JOURNAL_RECORD = {
+		.name     = "flash journal",
+		.magic    = FLASH_JOURNAL_MAGIC,
+		.version  = FLASH_JOURNAL_VERSION,
+		.key_len  = sizeof(Flash_Journal_Key),
+		.data_len = sizeof(uint32_t)
+};
+
+static void _get_journal_file_path(const Flash_Journal_Key* key, char* path,
+		size_t path_len);
+
+/*
+ * 64-bit FNV-1a. It only has to tell images apart, not resist tampering, and
+ * is cheap enough to run over the whole image on every update.
+ */
+uint64_t calculate_flash_journal_hash(const uint8_t* data, size_t len)
+{
+	uint64_t hash = FNV1A_64_OFFSET_BASIS;
+
+	for (size_t i = 0; i < len; i++) {
+		hash ^= data[i];
+		hash *= FNV1A_64_PRIME;
+	}
+
+	return hash;
+}
+
+void delete_flash_journal(const Flash_Journal_Key* key)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	char path[FLASH_JOURNAL_FILE_MAX_STRLEN];
+
+	if (key == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return;
+	}
+
+	_get_journal_file_path(key, path, sizeof(path));
+	if (0 != unlink(path) && errno != ENOENT) {
+		output(DEBUG, "Failed to delete the flash journal %s. %s [%d]\n",
+				path, strerror(errno), errno);
+	}
+}
+
+int load_flash_journal(const Flash_Journal_Key* key, uint32_t* written_len)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	char path[FLASH_JOURNAL_FILE_MAX_STRLEN];
+	uint32_t journal_written_len;
+
+	if (key == NULL || written_len == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return EXIT_FAILURE;
+	}
+
+	_get_journal_file_path(key, path, sizeof(path));
+	if (EXIT_SUCCESS != load_cache_record(&FLASH_JOURNAL_RECORD, path, key,
+			&journal_written_len)) {
+		return EXIT_FAILURE;
+	} else if (journal_written_len > key->image_len) {
+		output(DEBUG, "Flash journal at %s is invalid.\n", path);
+		return EXIT_FAILURE;
+	}
+
+	*written_len = journal_written_len;
+	output(DEBUG, "Flash journal at %s has %u bytes written.\n", path,
+			journal_written_len);
+	return EXIT_SUCCESS;
+}
+
+int save_flash_journal(const Flash_Journal_Key* key, uint32_t written_len)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	char path[FLASH_JOURNAL_FILE_MAX_STRLEN];
+
+	if (key == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return EXIT_FAILURE;
+	}
+
+	_get_journal_file_path(key, path, sizeof(path));
+	return save_cache_record(&FLASH_JOURNAL_RECORD, path, key, &written_len);
+}
+
+/*
+ * There is one journal per device and flash file, so a journal left behind
+ * by an older image is replaced instead of piling up.
+ */
+static void _get_journal_file_path(const Flash_Journal_Key* key, char* path,
+		size_t path_len)
+{
+	const uint8_t* id = key->device_id;
+
+	snprintf(path, path_len,
+			"%s/%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X_%u"
+			".flash_journal",
+			FLASH_JOURNAL_DIR, id[0], id[1], id[2], id[3], id[4], id[5],
+			id[6], id[7], id[8], id[9], id[10], id[11], key->file_num);
+}
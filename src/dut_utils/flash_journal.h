@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#ifndef PTLIB_DUT_UTILS_FLASH_JOURNAL_H_
+#define PTLIB_DUT_UTILS_FLASH_JOURNAL_H_
+
+#include "../logging.h"
+#include <stdint.h>
+#include "../file/ptlib_file.h"
+
+#define FLASH_JOURNAL_DIR PTLIB_CACHE_DIR
+
+/*
+ * Identifies the flash file write that a journal belongs to. The device ID is
+ * the silicon UID reported by the PIP3 VERSION command, or all zeros when the
+ * flash loader cannot report it.
+ */
+typedef struct {
+	uint8_t device_id[12];
+	uint8_t file_num;
+	uint32_t image_len;
+	uint64_t image_hash;
+} __attribute__((packed)) Flash_Journal_Key;
+
+extern uint64_t calculate_flash_journal_hash(const uint8_t* data, size_t len);
+extern void delete_flash_journal(const Flash_Journal_Key* key);
+extern int load_flash_journal(const Flash_Journal_Key* key,
+		uint32_t* written_len);
+extern int save_flash_journal(const Flash_Journal_Key* key,
+		uint32_t written_len);
+
+#endif
@@ -218,3 +218,108 @@ Poll_Status fpoll_inbound_data(FILE* fptr, time_t timeout)
 		return POLL_STATUS_GOT_DATA;
 	}
 }
+
+int load_cache_record(const Cache_Record_Type* type, const char* path,
+		const void* key, void* data)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	size_t header_len = sizeof(type->magic) + sizeof(type->version);
+	size_t record_len = header_len + type->key_len + type->data_len;
+	uint32_t magic;
+	uint16_t version;
+	uint8_t* record = NULL;
+	FILE* fptr = NULL;
+	int rc = EXIT_FAILURE;
+
+	fptr = fopen(path, "rb");
+	if (fptr == NULL) {
+		output(DEBUG, "No %s at %s.\n", type->name, path);
+		return EXIT_FAILURE;
+	}
+
+	record = malloc(record_len);
+	if (record == NULL) {
+		output(ERROR, "%s: Memory allocation failed.\n", __func__);
+		goto RETURN;
+	}
+
+	if (1 != fread(record, record_len, 1, fptr)) {
+		output(DEBUG, "The %s at %s is truncated.\n", type->name, path);
+		goto RETURN;
+	}
+
+	memcpy(&magic, record, sizeof(magic));
+	memcpy(&version, &record[sizeof(magic)], sizeof(version));
+	if (magic != type->magic || version != type->version
+			|| 0 != memcmp(&record[header_len], key, type->key_len)) {
+		output(DEBUG, "The %s at %s is stale.\n", type->name, path);
+		goto RETURN;
+	}
+
+	memcpy(data, &record[header_len + type->key_len], type->data_len);
+	output(DEBUG, "Loaded the %s from %s.\n", type->name, path);
+	rc = EXIT_SUCCESS;
+
+RETURN:
+	free(record);
+	fclose(fptr);
+	return rc;
+}
+
+/*
+ * The record is written to a temporary file that is then renamed over the
+ * old one, so an interrupted save never leaves a partial record behind.
+ */
+int save_cache_record(const Cache_Record_Type* type, const char* path,
+		const void* key, const void* data)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	size_t header_len = sizeof(type->magic) + sizeof(type->version);
+	size_t record_len = header_len + type->key_len + type->data_len;
+	char tmp_path[PATH_MAX];
+	uint8_t* record = NULL;
+	FILE* fptr = NULL;
+	int rc = EXIT_FAILURE;
+
+	if (mkdir(PTLIB_CACHE_DIR, 0755) < 0 && errno != EEXIST) {
+		output(DEBUG, "Cannot create %s. %s [%d]\n", PTLIB_CACHE_DIR,
+				strerror(errno), errno);
+		return EXIT_FAILURE;
+	}
+
+	record = malloc(record_len);
+	if (record == NULL) {
+		output(ERROR, "%s: Memory allocation failed.\n", __func__);
+		return EXIT_FAILURE;
+	}
+	memcpy(record, &type->magic, sizeof(type->magic));
+	memcpy(&record[sizeof(type->magic)], &type->version,
+			sizeof(type->version));
+	memcpy(&record[header_len], key, type->key_len);
+	memcpy(&record[header_len + type->key_len], data, type->data_len);
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	fptr = fopen(tmp_path, "wb");
+	if (fptr == NULL) {
+		output(DEBUG, "Cannot write %s. %s [%d]\n", tmp_path, strerror(errno),
+				errno);
+		free(record);
+		return EXIT_FAILURE;
+	}
+
+	if (1 == fwrite(record, record_len, 1, fptr)) {
+		rc = EXIT_SUCCESS;
+	}
+	free(record);
+
+	if (EOF == fclose(fptr) || rc != EXIT_SUCCESS
+			|| 0 != rename(tmp_path, path)) {
+		output(DEBUG, "Failed to save the %s to %s. %s [%d]\n", type->name,
+				path, strerror(errno), errno);
+		unlink(tmp_path);
+		return EXIT_FAILURE;
+	}
+
+	output(DEBUG, "Saved the %s to %s.\n", type->name, path);
+	return EXIT_SUCCESS;
+}
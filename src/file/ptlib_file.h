@@ -5,10 +5,14 @@
 #ifndef _PTLIB_FILE_H
 #define _PTLIB_FILE_H
 
+#include <limits.h>
 #include <regex.h>
+#include <sys/stat.h>
 #include "../ptstr_char.h"
 #include "../logging.h"
 
+#define PTLIB_CACHE_DIR "/var/cache/ptupdater"
+
 typedef enum {
 	POLL_STATUS_GOT_DATA,
 	POLL_STATUS_TIMEOUT,
@@ -17,10 +21,27 @@ typedef enum {
 	NUM_OF_POLL_STATUSES
 } Poll_Status;
 
+/*
+ * Describes a kind of record kept under PTLIB_CACHE_DIR. A record file holds
+ * the magic number, the version, the key it was saved for and then the data,
+ * and it is only loaded back for the same magic number, version and key.
+ */
+typedef struct {
+	const char* name;
+	uint32_t magic;
+	uint16_t version;
+	size_t key_len;
+	size_t data_len;
+} Cache_Record_Type;
+
 extern int file_copy(char *copy_from_path, char *copy_to_path);
 extern int file_insert(char *source_file_path, char *working_dir,
 		char *regex_str,
 		char *string_to_insert);
 extern Poll_Status fpoll_inbound_data(FILE* fptr, time_t timeout);
+extern int load_cache_record(const Cache_Record_Type* type, const char* path,
+		const void* key, void* data);
+extern int save_cache_record(const Cache_Record_Type* type, const char* path,
+		const void* key, const void* data);
 
 #endif 
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#include "hid_desc_cache.h"
+
+#define HID_DESC_CACHE_MAGIC   0x43445450
+#define HID_DESC_CACHE_VERSION 1
+#define HID_DESC_CACHE_FILE_MAX_STRLEN 64
+
+static const Cache_Record_Type HID_DESC_CACHE_RECORD = {
+		.name     = "cached HID descriptor",
+		.magic    = HID_DESC_CACHE_MAGIC,
+		.version  = HID_DESC_CACHE_VERSION,
+		.key_len  = sizeof(HID_Desc_Cache_Key),
+		.data_len = sizeof(HID_Descriptor)
+};
+
+static void _get_cache_file_path(const HID_Desc_Cache_Key* key, char* path,
+		size_t path_len);
+
+int load_cached_hid_descriptor(const HID_Desc_Cache_Key* key,
+		HID_Descriptor* hid_desc)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	char path[HID_DESC_CACHE_FILE_MAX_STRLEN];
+	HID_Descriptor cached_hid_desc;
+
+	if (key == NULL || hid_desc == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return EXIT_FAILURE;
+	}
+
+	_get_cache_file_path(key, path, sizeof(path));
+	if (EXIT_SUCCESS != load_cache_record(&HID_DESC_CACHE_RECORD, path, key,
+			&cached_hid_desc)) {
+		return EXIT_FAILURE;
+	} else if (cached_hid_desc.max_input_len <= 2
+			|| cached_hid_desc.max_output_len <= 2) {
+		output(DEBUG, "Cached HID descriptor at %s is invalid.\n", path);
+		return EXIT_FAILURE;
+	}
+
+	memcpy((void*) hid_desc, (void*) &cached_hid_desc, sizeof(*hid_desc));
+	return EXIT_SUCCESS;
+}
+
+int save_cached_hid_descriptor(const HID_Desc_Cache_Key* key,
+		const HID_Descriptor* hid_desc)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	char path[HID_DESC_CACHE_FILE_MAX_STRLEN];
+
+	if (key == NULL || hid_desc == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return EXIT_FAILURE;
+	}
+
+	_get_cache_file_path(key, path, sizeof(path));
+	return save_cache_record(&HID_DESC_CACHE_RECORD, path, key, hid_desc);
+}
+
+static void _get_cache_file_path(const HID_Desc_Cache_Key* key, char* path,
+		size_t path_len)
+{
+	snprintf(path, path_len, "%s/%04X_%04X_%04X.hid_desc", HID_DESC_CACHE_DIR,
+			key->bustype, key->vendor_id, key->product_id);
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#ifndef PTLIB_HID_DESC_CACHE_H_
+#define PTLIB_HID_DESC_CACHE_H_
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "../file/ptlib_file.h"
+#include "../logging.h"
+#include "hid.h"
+
+#define HID_DESC_CACHE_DIR PTLIB_CACHE_DIR
+
+typedef struct {
+	uint32_t bustype;
+	uint16_t vendor_id;
+	uint16_t product_id;
+	uint16_t rpt_desc_len;
+	uint16_t rpt_desc_crc;
+} __attribute__((packed)) HID_Desc_Cache_Key;
+
+extern int load_cached_hid_descriptor(const HID_Desc_Cache_Key* key,
+		HID_Descriptor* hid_desc);
+extern int save_cached_hid_descriptor(const HID_Desc_Cache_Key* key,
+		const HID_Descriptor* hid_desc);
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#include "hid_report_desc.h"
+
+#define HID_ITEM_TYPE_MAIN   0
+#define HID_ITEM_TYPE_GLOBAL 1
+
+#define HID_MAIN_ITEM_TAG_INPUT   0x8
+#define HID_MAIN_ITEM_TAG_OUTPUT  0x9
+#define HID_MAIN_ITEM_TAG_FEATURE 0xB
+
+#define HID_GLOBAL_ITEM_TAG_REPORT_SIZE  0x7
+#define HID_GLOBAL_ITEM_TAG_REPORT_ID    0x8
+#define HID_GLOBAL_ITEM_TAG_REPORT_COUNT 0x9
+#define HID_GLOBAL_ITEM_TAG_PUSH         0xA
+#define HID_GLOBAL_ITEM_TAG_POP          0xB
+
+#define HID_LONG_ITEM_PREFIX 0xFE
+#define HID_GLOBAL_STACK_DEPTH 8
+
+char* HID_REPORT_TYPE_NAMES[] = {
+		[HID_REPORT_TYPE_INPUT]   = "Input",
+		[HID_REPORT_TYPE_OUTPUT]  = "Output",
+		[HID_REPORT_TYPE_FEATURE] = "Feature",
+};
+
+typedef struct {
+	uint32_t report_size;
+	uint32_t report_count;
+	uint8_t  report_id;
+} Global_State;
+
+size_t get_hid_report_len(const HID_Report_Sizes* sizes,
+		HID_Report_Type type, uint8_t report_id)
+{
+	uint32_t bits = sizes->bits[type][report_id];
+	if (bits == 0) {
+		return 0;
+	}
+
+	return (bits + 7) / 8 + (sizes->uses_report_ids ? 1 : 0);
+}
+
+size_t get_max_hid_report_len(const HID_Report_Sizes* sizes,
+		HID_Report_Type type)
+{
+	size_t max_len = 0;
+
+	for (int id = 0; id < HID_NUM_OF_REPORT_IDS; id++) {
+		size_t len = get_hid_report_len(sizes, type, id);
+		if (len > max_len) {
+			max_len = len;
+		}
+	}
+
+	return max_len;
+}
+
+int parse_hid_report_descriptor(const uint8_t* desc, size_t desc_len,
+		HID_Report_Sizes* sizes)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	Global_State state = { 0 };
+	Global_State stack[HID_GLOBAL_STACK_DEPTH];
+	uint stack_depth = 0;
+	size_t i = 0;
+
+	if (desc == NULL || sizes == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return EXIT_FAILURE;
+	}
+
+	memset(sizes, 0, sizeof(*sizes));
+
+	while (i < desc_len) {
+		uint8_t prefix = desc[i++];
+
+		if (prefix == HID_LONG_ITEM_PREFIX) {
+			if (i + 2 > desc_len) {
+				break;
+			}
+			i += 2 + desc[i];
+			continue;
+		}
+
+		uint8_t data_size = (prefix & 0x3) == 3 ? 4 : (prefix & 0x3);
+		uint8_t type = (prefix >> 2) & 0x3;
+		uint8_t tag = prefix >> 4;
+		uint32_t data = 0;
+
+		if (i + data_size > desc_len) {
+			output(ERROR, "%s: Item at offset %lu runs past the end of the "
+					"report descriptor.\n", __func__, i - 1);
+			return EXIT_FAILURE;
+		}
+		for (int byte = 0; byte < data_size; byte++) {
+			data |= (uint32_t) desc[i + byte] << (8 * byte);
+		}
+		i += data_size;
+
+		if (type == HID_ITEM_TYPE_GLOBAL) {
+			switch (tag) {
+			case HID_GLOBAL_ITEM_TAG_REPORT_SIZE:
+				state.report_size = data;
+				break;
+			case HID_GLOBAL_ITEM_TAG_REPORT_ID:
+				if (data == 0 || data >= HID_NUM_OF_REPORT_IDS) {
+					output(ERROR, "%s: Invalid Report ID %u.\n", __func__,
+							data);
+					return EXIT_FAILURE;
+				}
+				state.report_id = (uint8_t) data;
+				sizes->uses_report_ids = true;
+				break;
+			case HID_GLOBAL_ITEM_TAG_REPORT_COUNT:
+				state.report_count = data;
+				break;
+			case HID_GLOBAL_ITEM_TAG_PUSH:
+				if (stack_depth >= HID_GLOBAL_STACK_DEPTH) {
+					output(ERROR, "%s: Push exceeds the supported depth of "
+							"%d.\n", __func__, HID_GLOBAL_STACK_DEPTH);
+					return EXIT_FAILURE;
+				}
+				stack[stack_depth++] = state;
+				break;
+			case HID_GLOBAL_ITEM_TAG_POP:
+				if (stack_depth == 0) {
+					output(ERROR, "%s: Pop without a matching Push.\n",
+							__func__);
+					return EXIT_FAILURE;
+				}
+				state = stack[--stack_depth];
+				break;
+			default:
+				;
+			}
+		} else if (type == HID_ITEM_TYPE_MAIN) {
+			HID_Report_Type report_type;
+
+			switch (tag) {
+			case HID_MAIN_ITEM_TAG_INPUT:
+				report_type = HID_REPORT_TYPE_INPUT;
+				break;
+			case HID_MAIN_ITEM_TAG_OUTPUT:
+				report_type = HID_REPORT_TYPE_OUTPUT;
+				break;
+			case HID_MAIN_ITEM_TAG_FEATURE:
+				report_type = HID_REPORT_TYPE_FEATURE;
+				break;
+			default:
+				continue;
+			}
+
+			sizes->bits[report_type][state.report_id] += (
+					state.report_size * state.report_count);
+		}
+	}
+
+	for (int type = 0; type < NUM_OF_HID_REPORT_TYPES; type++) {
+		for (int id = 0; id < HID_NUM_OF_REPORT_IDS; id++) {
+			if (sizes->bits[type][id] != 0) {
+				output(DEBUG, "Report ID 0x%02X %s report: %lu bytes.\n", id,
+						HID_REPORT_TYPE_NAMES[type],
+						get_hid_report_len(sizes, type, id));
+			}
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
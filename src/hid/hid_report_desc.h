@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#ifndef PTLIB_HID_REPORT_DESC_H_
+#define PTLIB_HID_REPORT_DESC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../logging.h"
+
+#define HID_NUM_OF_REPORT_IDS 256
+
+typedef enum {
+	HID_REPORT_TYPE_INPUT,
+	HID_REPORT_TYPE_OUTPUT,
+	HID_REPORT_TYPE_FEATURE,
+	NUM_OF_HID_REPORT_TYPES
+} HID_Report_Type;
+
+extern char* HID_REPORT_TYPE_NAMES[NUM_OF_HID_REPORT_TYPES];
+
+typedef struct {
+	bool     uses_report_ids;
+	uint32_t bits[NUM_OF_HID_REPORT_TYPES][HID_NUM_OF_REPORT_IDS];
+} HID_Report_Sizes;
+
+extern size_t get_hid_report_len(const HID_Report_Sizes* sizes,
+		HID_Report_Type type, uint8_t report_id);
+extern size_t get_max_hid_report_len(const HID_Report_Sizes* sizes,
+		HID_Report_Type type);
+extern int parse_hid_report_descriptor(const uint8_t* desc, size_t desc_len,
+		HID_Report_Sizes* sizes);
+
+#endif
@@ -5,18 +5,57 @@
 #include "hidraw.h"
 
 #define HIDRAW_SYSFS_NODE_FILE_MAX_STRLEN 20
-#define REPORT_BUFFER_SIZE 256 
+#define HIDRAW_WRITE_MAX_RETRIES 10
+#define HIDRAW_SYSFS_CLASS_DIR "/sys/class/hidraw"
+#define HIDRAW_DETECT_CACHE_FILE_MAX_STRLEN 64
+#define HIDRAW_UEVENT_LINE_MAX_STRLEN 256
+#define HIDRAW_URING_POSTED_READS 8
+#define HIDRAW_URING_SEND_DEPTH 16
+#define HIDRAW_URING_CANCEL_USER_DATA UINT64_MAX
 
 static char hidraw_sysfs_node_file[HIDRAW_SYSFS_NODE_FILE_MAX_STRLEN] =
 		HIDRAW0_SYSFS_NODE_FILE;
 static int hidraw0_fd;
 static bool hidraw0_open = false;
 
-static int self_pipe_fd[2];
-enum { SELF_PIPE_READ, SELF_PIPE_WRITE };
-static bool stop_reading;
+static uint        num_reports_sent;
+static long double report_send_time_us;
+
+#define REACTOR_MAX_SOURCES 8
+
+typedef struct Reactor_Source {
+	int fd;
+	Poll_Status (*on_readable)(struct Reactor_Source* source);
+} Reactor_Source;
+
+static int            reactor_epoll_fd = -1;
+static Reactor_Source reactor_sources[REACTOR_MAX_SOURCES];
+static uint           reactor_num_sources;
+static int            stop_event_fd = -1;
+static int            deadline_timer_fd = -1;
+static bool           deadline_expired;
+
+/*
+ * When the io_uring transport is active several reads are kept posted on the
+ * HIDRAW node and their completions are reaped through the report reactor,
+ * while output reports are written through a separate ring owned by the
+ * consumer thread. Each posted read is identified by its index in
+ * uring_read_slots, which records the report slot it is reading into.
+ */
+static PtUring report_uring = { .fd = -1 };
+static PtUring send_uring = { .fd = -1 };
+static bool    uring_active = false;
+static uint    uring_read_slots[HIDRAW_URING_POSTED_READS];
+static uint    uring_reads_in_flight;
 
 static pthread_t   report_reader_tid;
+static int         report_reader_rt_priority = SCHED_RT_PRIORITY_NONE;
+static int         report_reader_cpu = SCHED_CPU_ANY;
+
+static uint        num_reports_picked_up;
+static long double report_pickup_ms;
+static long double report_pickup_min_ms;
+static long double report_pickup_max_ms;
 
 typedef enum {
 	REPORT_READER_THREAD_STATUS_ACTIVE,
@@ -27,45 +66,118 @@ typedef enum {
 static Report_Reader_Thread_Status report_reader_thread_status;
 static Poll_Status                 report_read_status;
 
+#define CACHE_LINE_SIZE 64
+
+char* HIDRAW_REPORT_QUEUE_NAMES[] = {
+		[HIDRAW_REPORT_QUEUE_SOLICITED]   = "Solicited response",
+		[HIDRAW_REPORT_QUEUE_UNSOLICITED] = "Unsolicited response",
+		[HIDRAW_REPORT_QUEUE_TOUCH]       = "Touch",
+		[HIDRAW_REPORT_QUEUE_OTHER]       = "Other",
+};
+
+/*
+ * Input reports are read into slots of one slab. Each report ID class has its
+ * own single-producer/single-consumer queue of slot indices, and slots are
+ * handed back to the reader through a free ring once the consumer releases
+ * them. Only the report reader thread writes a queue head or the free ring
+ * tail and only the consumer writes a queue tail or the free ring head, so
+ * neither side takes a lock. The mutex and condition variable are used only
+ * when the consumer has to sleep on an empty queue.
+ */
 typedef struct {
-	ReportData report;
-	bool ready;
-} Buffer_Entry;
+	uint  head __attribute__((aligned(CACHE_LINE_SIZE)));
+	uint  delivered;
+	uint  dropped;
+	uint  tail __attribute__((aligned(CACHE_LINE_SIZE)));
+	uint  depth __attribute__((aligned(CACHE_LINE_SIZE)));
+	uint* entries;
+} Report_Queue;
+
+static Report_Queue report_queues[NUM_OF_HIDRAW_REPORT_QUEUES];
+static uint         report_queue_depths[NUM_OF_HIDRAW_REPORT_QUEUES] = {
+		[HIDRAW_REPORT_QUEUE_SOLICITED]   = HIDRAW_REPORT_BUFFER_DEFAULT_DEPTH,
+		[HIDRAW_REPORT_QUEUE_UNSOLICITED] = HIDRAW_REPORT_BUFFER_DEFAULT_DEPTH,
+		[HIDRAW_REPORT_QUEUE_TOUCH]       = HIDRAW_TOUCH_REPORT_QUEUE_DEPTH,
+		[HIDRAW_REPORT_QUEUE_OTHER]       = HIDRAW_OTHER_REPORT_QUEUE_DEPTH,
+};
+static Report_Queue free_slot_ring;
 
-static pthread_mutex_t report_buffer_mutex;
-static Buffer_Entry    report_buffer[REPORT_BUFFER_SIZE] = {NULL};
+static bool consumer_waiting __attribute__((aligned(CACHE_LINE_SIZE)));
+static Report_Queue* borrowed_queue = NULL;
+static uint          reader_slot;
+static uint          num_reader_slots;
 
-static uint            report_buffer_least_recent_index;
-static uint            report_buffer_count;
+static pthread_mutex_t report_buffer_mutex;
+static pthread_cond_t  report_buffer_cond;
+static ReportData*     report_slots = NULL;
+static uint            num_report_slots;
+static uint8_t*        report_slab = NULL;
+static uint*           report_queue_entries = NULL;
+static struct timespec report_reader_start_time;
 
 static HID_Descriptor _hid_desc;
 static bool hid_desc_read = false;
 static size_t hid_output_report_size;
 static size_t hid_input_report_size;
 
-static Poll_Status _consume_report(HID_Report_ID target_report_id,
-		uint* next_victim_report_index, bool* more_reports);
+static void _cancel_uring_reads();
+static Poll_Status _drain_hidraw_reports(Reactor_Source* source);
+static Report_Queue* _find_ready_queue(HID_Report_ID report_id);
 static int _get_max_input_len();
+static int _get_max_lens_from_rpt_desc(
+		const struct hidraw_report_descriptor* rpt_desc, int* max_input_len,
+		int* max_output_len);
 static int _get_max_output_len();
-static Poll_Status _read_report(ReportData* report);
-static void* _report_reader_thread(void* arg);
-static int _try_hidraw_sysfs_node(char* sysfs_node_file, int vendor_id,
+static HIDRAW_Report_Queue _get_report_queue(HID_Report_ID report_id);
+static Poll_Status _handle_deadline_timer(Reactor_Source* source);
+static Poll_Status _handle_stop_event(Reactor_Source* source);
+static void _format_detected_hidraw_node(const char* node_name,
+		char* sysfs_node_file, size_t sysfs_node_file_size);
+static int _match_hidraw_uevent(const char* node_name, int vendor_id,
 		int product_id);
+static bool _pop_free_slot(uint* slot);
+static int _post_uring_read(uint index);
+static bool _publish_report(uint* slot);
+static void _push_free_slot(uint slot);
+static int _reactor_add_source(int fd,
+		Poll_Status (*on_readable)(Reactor_Source* source));
+static Poll_Status _reactor_dispatch();
+static Poll_Status _reap_uring_reports(Reactor_Source* source);
+static void* _report_reader_thread(void* arg);
+static int _start_report_reader(HID_Report_ID report_id, bool use_io_uring);
+static Poll_Status _wait_for_queue_data(HID_Report_ID report_id,
+		Report_Queue** queue, bool apply_timeout, long double timeout_val);
 
 Channel hidraw_channel = {
 	.type               = CHANNEL_TYPE_HIDRAW,
 	.setup              = start_hidraw_report_reader,
 	.get_hid_descriptor = get_hid_descriptor_from_hidraw,
 	.send_report        = send_report_via_hidraw,
+	.send_reports       = send_reports_via_hidraw,
+	.get_report         = get_report_from_hidraw,
+	.borrow_report      = borrow_report_from_hidraw,
+	.release_report     = release_report_to_hidraw,
+	.teardown           = stop_hidraw_report_reader,
+};
+
+Channel hidraw_uring_channel = {
+	.type               = CHANNEL_TYPE_HIDRAW,
+	.setup              = start_hidraw_uring_report_reader,
+	.get_hid_descriptor = get_hid_descriptor_from_hidraw,
+	.send_report        = send_report_via_hidraw_uring,
+	.send_reports       = send_reports_via_hidraw_uring,
 	.get_report         = get_report_from_hidraw,
+	.borrow_report      = borrow_report_from_hidraw,
+	.release_report     = release_report_to_hidraw,
 	.teardown           = stop_hidraw_report_reader,
 };
 
-int auto_detect_hidraw_sysfs_node(int vendor_id, int product_id)
+int auto_detect_hidraw_sysfs_node(int vendor_id, int product_id,
+		bool use_cache, char* sysfs_node_file, size_t sysfs_node_file_size)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
 
-	if (vendor_id > 0xFFFF) {
+	if (vendor_id < 0 || vendor_id > 0xFFFF) {
 		output(ERROR,
 				"%s: Invalid vendor ID. It must be less than 0xFFFF but got "
 				"0x%X.\n", __func__, vendor_id);
@@ -77,70 +189,184 @@ int auto_detect_hidraw_sysfs_node(int vendor_id, int product_id)
 		return EXIT_FAILURE;
 	}
 
-	DIR* dev_dir;
-	bool dev_dir_opened = false;
+	DIR* class_dir;
 	regex_t regex;
 	bool sysfs_node_found = false;
+	char cache_file[HIDRAW_DETECT_CACHE_FILE_MAX_STRLEN];
+	char node_name[NAME_MAX + 1];
 
-	if (regcomp(&regex, "hidraw[[:digit:]+]$", 0)) {
+	if (product_id == HID_PRODUCT_ID_ANY) {
+		snprintf(cache_file, sizeof(cache_file), "%s/hidraw_%04X_any",
+				HID_DESC_CACHE_DIR, vendor_id);
+	} else {
+		snprintf(cache_file, sizeof(cache_file), "%s/hidraw_%04X_%04X",
+				HID_DESC_CACHE_DIR, vendor_id, product_id);
+	}
+
+	if (regcomp(&regex, "^hidraw[[:digit:]]\\+$", 0)) {
 		output(ERROR,
 				"%s: Failed to compile the regex pattern.\n", __func__);
 		return EXIT_FAILURE;
 	}
 
-	dev_dir = opendir("/dev/");
-	if (dev_dir == NULL) {
-		output(ERROR, "%s: Failed to open the /dev/ directory. %s [%d]\n",
-				__func__,  strerror(errno), errno);
-		goto RETURN;
+	if (use_cache) {
+		FILE* fptr = fopen(cache_file, "r");
+		if (fptr != NULL) {
+			if (1 == fscanf(fptr, "%255s", node_name)
+					&& regexec(&regex, node_name, 0, NULL, 0) == 0
+					&& EXIT_SUCCESS == _match_hidraw_uevent(node_name,
+							vendor_id, product_id)) {
+				output(DEBUG, "Using cached HIDRAW node %s.\n", node_name);
+				sysfs_node_found = true;
+			}
+			fclose(fptr);
+		}
+
+		if (sysfs_node_found) {
+			regfree(&regex);
+			_format_detected_hidraw_node(node_name, sysfs_node_file,
+					sysfs_node_file_size);
+			return EXIT_SUCCESS;
+		}
+	}
+
+	class_dir = opendir(HIDRAW_SYSFS_CLASS_DIR);
+	if (class_dir == NULL) {
+		output(ERROR, "%s: Failed to open the %s directory. %s [%d]\n",
+				__func__, HIDRAW_SYSFS_CLASS_DIR, strerror(errno), errno);
+		regfree(&regex);
+		return EXIT_FAILURE;
 	}
-	dev_dir_opened = true;
 
 	while (!sysfs_node_found) {
-		const struct dirent* dev_dir_entry = readdir(dev_dir);
-		if (dev_dir_entry == NULL) {
-			output(ERROR,
-					"%s: Failed to read from the /dev/ directory. %s [%d]\n",
-					__func__,  strerror(errno), errno);
-			goto RETURN;
+		errno = 0;
+		const struct dirent* class_dir_entry = readdir(class_dir);
+		if (class_dir_entry == NULL) {
+			if (errno != 0) {
+				output(ERROR,
+						"%s: Failed to read from the %s directory. %s [%d]\n",
+						__func__, HIDRAW_SYSFS_CLASS_DIR, strerror(errno),
+						errno);
+			}
+			break;
+		}
+
+		if (regexec(&regex, class_dir_entry->d_name, 0, NULL, 0) == 0
+				&& EXIT_SUCCESS == _match_hidraw_uevent(
+						class_dir_entry->d_name, vendor_id, product_id)) {
+			snprintf(node_name, sizeof(node_name), "%s",
+					class_dir_entry->d_name);
+			sysfs_node_found = true;
 		}
+	}
 
-		if (regexec(&regex, dev_dir_entry->d_name, 0, NULL, 0) == 0) {
-			char sysfs_node_file[HIDRAW_SYSFS_NODE_FILE_MAX_STRLEN];
-			snprintf(sysfs_node_file, HIDRAW_SYSFS_NODE_FILE_MAX_STRLEN,
-					"/dev/%s", dev_dir_entry->d_name);
+	(void) closedir(class_dir);
+	regfree(&regex);
 
-			output(INFO, "Trying HIDRAW sysfs node = '%s'\n", sysfs_node_file);
+	if (!sysfs_node_found) {
+		output(ERROR,
+				"%s: No HIDRAW device found with VID = 0x%04X and PID = %s.\n",
+				__func__, vendor_id,
+				product_id == HID_PRODUCT_ID_ANY ? "any" : "the given PID");
+		return EXIT_FAILURE;
+	}
 
-			if (EXIT_SUCCESS == _try_hidraw_sysfs_node(sysfs_node_file,
-													vendor_id, product_id)) {
-				sysfs_node_found = true;
+	if (use_cache) {
+		if (mkdir(HID_DESC_CACHE_DIR, 0755) < 0 && errno != EEXIST) {
+			output(DEBUG, "Cannot create %s. %s [%d]\n", HID_DESC_CACHE_DIR,
+					strerror(errno), errno);
+		} else {
+			FILE* fptr = fopen(cache_file, "w");
+			if (fptr != NULL) {
+				fprintf(fptr, "%s\n", node_name);
+				fclose(fptr);
 			}
 		}
 	}
 
-RETURN:
-	if (dev_dir_opened) {
-		(void) closedir(dev_dir);
+	_format_detected_hidraw_node(node_name, sysfs_node_file,
+			sysfs_node_file_size);
+	return EXIT_SUCCESS;
+}
+
+Poll_Status borrow_report_from_hidraw(HID_Report_ID report_id,
+		ReportData** report, bool apply_timeout, long double timeout_val)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	Poll_Status rc;
+	Report_Queue* queue;
+
+	if (report == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return POLL_STATUS_ERROR;
+	} else if (borrowed_queue != NULL) {
+		output(ERROR, "%s: The previously borrowed report was not released.\n",
+				__func__);
+		return POLL_STATUS_ERROR;
 	}
 
-	regfree(&regex);
+	switch (__atomic_load_n(&report_reader_thread_status, __ATOMIC_ACQUIRE)) {
+	case REPORT_READER_THREAD_STATUS_NOT_STARTED:
+		output(ERROR, "%s: Report reader thread has not been started.\n",
+				__func__);
+		return POLL_STATUS_ERROR;
+	case REPORT_READER_THREAD_STATUS_EXIT:
+		if (_find_ready_queue(report_id) == NULL) {
+			output(DEBUG, "Report reader thread has already terminated. "
+					"No more reports to read.\n");
+			return POLL_STATUS_SKIP;
+		}
+		break;
+	default: 
+		;
+	}
+
+	queue = _find_ready_queue(report_id);
+	if (queue == NULL) {
+		rc = _wait_for_queue_data(report_id, &queue, apply_timeout,
+				timeout_val);
+		if (rc != POLL_STATUS_GOT_DATA) {
+			return rc;
+		}
+	}
+
+	*report = &report_slots[queue->entries[queue->tail & (queue->depth - 1)]];
+	borrowed_queue = queue;
+
+	/*
+	 * Track how long reports sit in the queues before they are picked up,
+	 * which shows how promptly the consumer is scheduled.
+	 */
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	long double pickup_ms = get_timespec_diff_ms(&(*report)->timestamp, &now);
+	if (num_reports_picked_up == 0 || pickup_ms < report_pickup_min_ms) {
+		report_pickup_min_ms = pickup_ms;
+	}
+	if (num_reports_picked_up == 0 || pickup_ms > report_pickup_max_ms) {
+		report_pickup_max_ms = pickup_ms;
+	}
+	report_pickup_ms += pickup_ms;
+	num_reports_picked_up++;
 
-	return sysfs_node_found ? EXIT_SUCCESS : EXIT_FAILURE;
+	return POLL_STATUS_GOT_DATA;
 }
 
 void clear_hidraw_report_buffer()
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
 
-	pthread_mutex_lock(&report_buffer_mutex);
-	for (int i = 0; i < REPORT_BUFFER_SIZE; i++) {
-		report_buffer[i].report.len = 0;
-		report_buffer[i].ready = false;
+	release_report_to_hidraw();
+
+	for (int i = 0; i < NUM_OF_HIDRAW_REPORT_QUEUES; i++) {
+		Report_Queue* queue = &report_queues[i];
+		uint head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+		while (queue->tail != head) {
+			_push_free_slot(queue->entries[queue->tail & (queue->depth - 1)]);
+			__atomic_store_n(&queue->tail, queue->tail + 1, __ATOMIC_RELEASE);
+		}
 	}
-	report_buffer_least_recent_index = 0;
-	report_buffer_count = 0;
-	pthread_mutex_unlock(&report_buffer_mutex);
 }
 
 int get_hid_descriptor_from_hidraw(HID_Descriptor* hid_desc)
@@ -154,6 +380,8 @@ int get_hid_descriptor_from_hidraw(HID_Descriptor* hid_desc)
 	int read_rc;
 	int rpt_desc_size;
 	struct hidraw_devinfo dev_info;
+	struct hidraw_report_descriptor rpt_desc;
+	HID_Desc_Cache_Key cache_key;
 
 	if (hid_desc == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
@@ -183,28 +411,54 @@ int get_hid_descriptor_from_hidraw(HID_Descriptor* hid_desc)
 		goto RETURN;
 	}
 
-	max_input_len = _get_max_input_len();
-	if (max_input_len <= 0) {
-		rc = EXIT_FAILURE;
-		goto RETURN;
-	}
-
-	max_output_len = _get_max_output_len();
-	if (max_output_len <= 0) {
+	read_rc = ioctl(fd, HIDIOCGRAWINFO, &dev_info);
+	if (read_rc < 0) {
+		output(ERROR,
+				"%s: Failed to read the raw device info from %s. "
+				"%s [%d]\n",
+				__func__, hidraw_sysfs_node_file, strerror(errno), errno);
 		rc = EXIT_FAILURE;
 		goto RETURN;
 	}
 
-	read_rc = ioctl(fd, HIDIOCGRAWINFO, &dev_info);
+	rpt_desc.size = rpt_desc_size;
+	read_rc = ioctl(fd, HIDIOCGRDESC, &rpt_desc);
 	if (read_rc < 0) {
 		output(ERROR,
-				"%s: Failed to read the raw device info from %s. "
-				"%s [%d]\n",
+				"%s: Failed to read the Report Descriptor from %s. %s [%d]\n",
 				__func__, hidraw_sysfs_node_file, strerror(errno), errno);
 		rc = EXIT_FAILURE;
 		goto RETURN;
 	}
 
+	cache_key.bustype      = dev_info.bustype;
+	cache_key.vendor_id    = dev_info.vendor;
+	cache_key.product_id   = dev_info.product;
+	cache_key.rpt_desc_len = (uint16_t) rpt_desc_size;
+	cache_key.rpt_desc_crc = calculate_crc16_ccitt(0xFFFF, rpt_desc.value,
+			rpt_desc.size);
+
+	if (EXIT_SUCCESS == load_cached_hid_descriptor(&cache_key, &_hid_desc)) {
+		goto COPY;
+	}
+
+	if (EXIT_SUCCESS != _get_max_lens_from_rpt_desc(&rpt_desc, &max_input_len,
+			&max_output_len)) {
+		output(DEBUG, "Probing the device for the max report lengths.\n");
+
+		max_input_len = _get_max_input_len();
+		if (max_input_len <= 0) {
+			rc = EXIT_FAILURE;
+			goto RETURN;
+		}
+
+		max_output_len = _get_max_output_len();
+		if (max_output_len <= 0) {
+			rc = EXIT_FAILURE;
+			goto RETURN;
+		}
+	}
+
 	_hid_desc.hid_desc_len      = 0x001E;
 	_hid_desc.bcd_version       = 0x0100;
 	_hid_desc.rpt_desc_len      = (uint16_t) rpt_desc_size;
@@ -219,6 +473,8 @@ int get_hid_descriptor_from_hidraw(HID_Descriptor* hid_desc)
 	_hid_desc.product_id        = dev_info.product;
 	_hid_desc.version_id        = 0x0000;
 
+	(void) save_cached_hid_descriptor(&cache_key, &_hid_desc);
+
 COPY:
 	memcpy((void*) hid_desc, (void*) &_hid_desc, sizeof(_hid_desc));
 	hid_desc_read = true;
@@ -231,65 +487,50 @@ RETURN:
 	return rc;
 }
 
-Poll_Status get_report_from_hidraw(ReportData* report, bool apply_timeout,
-		long double timeout_val)
+uint get_hidraw_report_drop_count(HID_Report_ID report_id)
+{
+	uint dropped = 0;
+
+	for (int i = 0; i < NUM_OF_HIDRAW_REPORT_QUEUES; i++) {
+		if (report_id == HID_REPORT_ID_ANY || i == _get_report_queue(report_id)) {
+			dropped += __atomic_load_n(&report_queues[i].dropped,
+					__ATOMIC_RELAXED);
+		}
+	}
+
+	return dropped;
+}
+
+const char* get_hidraw_sysfs_node_file()
+{
+	return hidraw_sysfs_node_file;
+}
+
+Poll_Status get_report_from_hidraw(HID_Report_ID report_id, ReportData* report,
+		bool apply_timeout, long double timeout_val)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
 	Poll_Status rc;
-	struct timeval start_time;
+	ReportData* slot;
 
 	if (report == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return POLL_STATUS_ERROR;
 	}
 
-	switch (report_reader_thread_status) {
-	case REPORT_READER_THREAD_STATUS_NOT_STARTED:
-		output(ERROR, "%s: Report reader thread has not been started.\n",
-				__func__);
-		return POLL_STATUS_ERROR;
-	case REPORT_READER_THREAD_STATUS_EXIT:
-		if (report_buffer_count == 0) {
-			output(DEBUG, "Report reader thread has already terminated. "
-					"No more reports to read.\n");
-			return POLL_STATUS_SKIP;
-		} else {
-			goto GET_REPORT;
-		}
-	default: 
-		;
-	}
-
-	gettimeofday(&start_time, 0);
-	while (report_buffer_count == 0
-			|| !report_buffer[report_buffer_least_recent_index].ready) {
-		if (report_reader_thread_status != REPORT_READER_THREAD_STATUS_ACTIVE) {
-			return report_read_status;
-		} else if (apply_timeout
-				&& time_limit_reached(&start_time, timeout_val)) {
-			return POLL_STATUS_TIMEOUT;
-		}
+	rc = borrow_report_from_hidraw(report_id, &slot, apply_timeout,
+			timeout_val);
+	if (rc != POLL_STATUS_GOT_DATA) {
+		return rc;
 	}
 
-GET_REPORT:
-	pthread_mutex_lock(&report_buffer_mutex);
-
-	memcpy((void*) report->data,
-			(void*) report_buffer[report_buffer_least_recent_index].report.data,
-			report_buffer[report_buffer_least_recent_index].report.len);
-	report->len = report_buffer[report_buffer_least_recent_index].report.len;
-	report_buffer[report_buffer_least_recent_index].report.len = 0;
-	report_buffer[report_buffer_least_recent_index].ready = false;
+	memcpy((void*) report->data, (void*) slot->data, slot->len);
+	report->len = slot->len;
+	report->timestamp = slot->timestamp;
 
-	rc = report_read_status;
+	release_report_to_hidraw();
 
-	report_buffer_least_recent_index = ((report_buffer_least_recent_index + 1)
-			% REPORT_BUFFER_SIZE);
-	report_buffer_count--;
-
-	pthread_mutex_unlock(&report_buffer_mutex);
-
-	return rc;
+	return POLL_STATUS_GOT_DATA;
 }
 
 int get_report_descriptor_from_hidraw(ReportData* rpt_desc)
@@ -390,155 +631,407 @@ int init_input_report(ReportData* report)
 	return EXIT_SUCCESS;
 }
 
-int send_report_via_hidraw(const ReportData* report)
+void release_report_to_hidraw()
 {
-	output(DEBUG, "%s: Starting.\n", __func__);
-	return write_report(report, hidraw_sysfs_node_file);
+	Report_Queue* queue = borrowed_queue;
+
+	if (queue == NULL) {
+		return;
+	}
+
+	_push_free_slot(queue->entries[queue->tail & (queue->depth - 1)]);
+	__atomic_store_n(&queue->tail, queue->tail + 1, __ATOMIC_RELEASE);
+	borrowed_queue = NULL;
 }
 
-int start_hidraw_report_reader(HID_Report_ID report_id)
+int send_report_via_hidraw(ReportData* report)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
-	int rc = EXIT_FAILURE;
-	HID_Descriptor hid_desc;
+	struct timespec start_time;
+	struct timespec end_time;
+	ssize_t write_rc = -1;
+
+	if (!hidraw0_open) {
+		int rc = write_report(report, hidraw_sysfs_node_file);
+		clock_gettime(CLOCK_MONOTONIC, &report->timestamp);
+		return rc;
+	}
 
-	report_reader_thread_status = REPORT_READER_THREAD_STATUS_NOT_STARTED;
-	report_buffer_least_recent_index = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
 
-	if (EXIT_SUCCESS != get_hid_descriptor_from_hidraw(&hid_desc)) {
-		rc = EXIT_FAILURE;
-		goto RETURN;
+	for (int attempt = 0; attempt < HIDRAW_WRITE_MAX_RETRIES; attempt++) {
+		write_rc = write(hidraw0_fd, report->data, report->len);
+		if (write_rc >= 0 || (errno != EINTR && errno != EAGAIN)) {
+			break;
+		} else if (errno == EAGAIN) {
+			sleep_ms(1);
+		}
 	}
 
-	hid_output_report_size = hid_desc.max_output_len - 2;
-	hid_input_report_size = hid_desc.max_input_len - 2;
-
-	hidraw0_fd = open(hidraw_sysfs_node_file, O_RDWR | O_NONBLOCK);
-	if (hidraw0_fd < 0) {
-		output(ERROR, "%s: Failed to open %s. %s [%d]\n", __func__,
+	if (write_rc < 0) {
+		output(ERROR, "%s: Failed to write to %s. %s [%d]\n", __func__,
 				hidraw_sysfs_node_file, strerror(errno), errno);
-		rc = EXIT_FAILURE;
-		goto RETURN;
+		return EXIT_FAILURE;
+	} else if (write_rc != report->len) {
+		output(ERROR,
+				"%s: Only %ld of %lu bytes were written to %s.\n", __func__,
+				write_rc, report->len, hidraw_sysfs_node_file);
+		return EXIT_FAILURE;
 	}
-	hidraw0_open = true;
 
-	if (pipe(self_pipe_fd) < 0) {
-		output(ERROR,
-				"%s: Failed to open pipe for communicating with report reader "
-				"thread. %s [%d]\n", __func__, strerror(errno), errno);
-		rc = EXIT_FAILURE;
-		goto RETURN;
+	clock_gettime(CLOCK_MONOTONIC, &end_time);
+	report->timestamp = end_time;
+	report_send_time_us += get_timespec_diff_ms(&start_time, &end_time) * 1e3L;
+	num_reports_sent++;
+
+	return EXIT_SUCCESS;
+}
+
+int send_report_via_hidraw_uring(ReportData* report)
+{
+	return send_reports_via_hidraw_uring(report, 1);
+}
+
+int send_reports_via_hidraw(ReportData* reports, uint num_reports)
+{
+	for (uint i = 0; i < num_reports; i++) {
+		if (EXIT_SUCCESS != send_report_via_hidraw(&reports[i])) {
+			return EXIT_FAILURE;
+		}
 	}
 
-	stop_reading = false;
+	return EXIT_SUCCESS;
+}
 
-	for (int i = 0; i < REPORT_BUFFER_SIZE; i++) {
-		report_buffer[i].report.max_len = hid_input_report_size;
-		report_buffer[i].report.len = 0;
-		report_buffer[i].ready = false;
-		report_buffer[i].report.data = malloc(report_buffer[i].report.max_len);
-		if (NULL == report_buffer[i].report.data) {
-			output(ERROR, "%s: Memory allocation failed.\n", __func__);
-			rc = EXIT_FAILURE;
-			goto RETURN;
+int send_reports_via_hidraw_uring(ReportData* reports, uint num_reports)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	struct timespec start_time;
+	struct timespec end_time;
+	int rc = EXIT_SUCCESS;
+
+	if (!uring_active) {
+		return send_reports_via_hidraw(reports, num_reports);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+	/*
+	 * The writes of each batch are linked so that the kernel issues them in
+	 * order, and the whole batch is submitted and reaped with one system call.
+	 */
+	for (uint sent = 0; sent < num_reports && rc == EXIT_SUCCESS;) {
+		uint batch = num_reports - sent;
+		if (batch > HIDRAW_URING_SEND_DEPTH) {
+			batch = HIDRAW_URING_SEND_DEPTH;
+		}
+
+		for (uint i = 0; i < batch; i++) {
+			ReportData* report = &reports[sent + i];
+			struct io_uring_sqe* sqe = get_uring_sqe(&send_uring);
+			prep_uring_rw(sqe, IORING_OP_WRITE, hidraw0_fd, report->data,
+					report->len, sent + i);
+			if (i < batch - 1) {
+				sqe->flags |= IOSQE_IO_LINK;
+			}
 		}
+
+		if (submit_uring(&send_uring, batch) < 0) {
+			output(ERROR, "%s: Failed to submit writes to %s. %s [%d]\n",
+					__func__, hidraw_sysfs_node_file, strerror(errno), errno);
+			return EXIT_FAILURE;
+		}
+
+		for (uint reaped = 0; reaped < batch;) {
+			struct io_uring_cqe* cqe = peek_uring_cqe(&send_uring);
+			if (cqe == NULL) {
+				if (submit_uring(&send_uring, 1) < 0) {
+					output(ERROR,
+							"%s: Failed to wait for writes to %s. %s [%d]\n",
+							__func__, hidraw_sysfs_node_file, strerror(errno),
+							errno);
+					return EXIT_FAILURE;
+				}
+				continue;
+			}
+
+			ReportData* report = &reports[cqe->user_data];
+			clock_gettime(CLOCK_MONOTONIC, &report->timestamp);
+			if (cqe->res < 0 && rc == EXIT_SUCCESS) {
+				output(ERROR, "%s: Failed to write to %s. %s [%d]\n",
+						__func__, hidraw_sysfs_node_file, strerror(-cqe->res),
+						-cqe->res);
+				rc = EXIT_FAILURE;
+			} else if (cqe->res >= 0 && cqe->res != report->len) {
+				output(ERROR,
+						"%s: Only %d of %lu bytes were written to %s.\n",
+						__func__, cqe->res, report->len, hidraw_sysfs_node_file);
+				rc = EXIT_FAILURE;
+			}
+			seen_uring_cqe(&send_uring);
+			reaped++;
+		}
+		sent += batch;
 	}
 
-	if (0 != pthread_create(&report_reader_tid, NULL, _report_reader_thread,
-			(void*) &report_id)) { 
-		output(ERROR,
-				"%s: Failed to start thread for reading reports from %s. "
-				"%s [%d]\n",
-				__func__, hidraw_sysfs_node_file, strerror(errno), errno);
-		rc = EXIT_FAILURE;
-		goto RETURN;
+	clock_gettime(CLOCK_MONOTONIC, &end_time);
+	report_send_time_us += get_timespec_diff_ms(&start_time, &end_time) * 1e3L;
+	num_reports_sent += num_reports;
+
+	return rc;
+}
+
+int set_hidraw_report_buffer_depth(uint depth)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	if (EXIT_SUCCESS != set_hidraw_report_queue_depth(
+					HIDRAW_REPORT_QUEUE_SOLICITED, depth)
+			|| EXIT_SUCCESS != set_hidraw_report_queue_depth(
+					HIDRAW_REPORT_QUEUE_UNSOLICITED, depth)) {
+		return EXIT_FAILURE;
 	}
 
-	while (report_reader_thread_status
-			== REPORT_READER_THREAD_STATUS_NOT_STARTED)
-			sleep_ms(1);
+	return EXIT_SUCCESS;
+}
 
-	rc = EXIT_SUCCESS;
+int set_hidraw_report_queue_depth(HIDRAW_Report_Queue queue, uint depth)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
 
-RETURN:
-	if (rc != EXIT_SUCCESS) {
-		stop_hidraw_report_reader();
+	if (queue >= NUM_OF_HIDRAW_REPORT_QUEUES) {
+		output(ERROR, "%s: Invalid report queue (%d).\n", __func__, queue);
+		return EXIT_FAILURE;
+	} else if (depth == 0 || depth > HIDRAW_REPORT_BUFFER_MAX_DEPTH) {
+		output(ERROR,
+				"%s: The report buffer depth must be between 1 and %u (%u was "
+				"given).\n",
+				__func__, HIDRAW_REPORT_BUFFER_MAX_DEPTH, depth);
+		return EXIT_FAILURE;
+	} else if (report_slots != NULL) {
+		output(ERROR,
+				"%s: Cannot resize the report buffer while the report reader "
+				"is running.\n", __func__);
+		return EXIT_FAILURE;
+	}
+
+	report_queue_depths[queue] = 1;
+	while (report_queue_depths[queue] < depth) {
+		report_queue_depths[queue] <<= 1;
 	}
 
+	output(DEBUG, "%s report queue depth set to %u.\n",
+			HIDRAW_REPORT_QUEUE_NAMES[queue], report_queue_depths[queue]);
 	return EXIT_SUCCESS;
 }
 
+void set_hidraw_report_reader_sched(int rt_priority, int cpu)
+{
+	report_reader_rt_priority = rt_priority;
+	report_reader_cpu = cpu;
+}
+
+int start_hidraw_report_reader(HID_Report_ID report_id)
+{
+	return _start_report_reader(report_id, false);
+}
+
+int start_hidraw_uring_report_reader(HID_Report_ID report_id)
+{
+	return _start_report_reader(report_id, true);
+}
+
 int stop_hidraw_report_reader()
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
 
-	stop_reading = true;
+	if (report_reader_thread_status != REPORT_READER_THREAD_STATUS_NOT_STARTED) {
+		uint64_t stop_signal = 1;
+		if (write(stop_event_fd, &stop_signal, sizeof(stop_signal)) < 0) {
+			output(ERROR,
+					"%s: Failed to signal the report reader thread to stop. "
+					"%s [%d]\n", __func__, strerror(errno), errno);
+		}
+
+		pthread_join(report_reader_tid, NULL);
+		pthread_cond_destroy(&report_buffer_cond);
+	}
+
+	struct timespec stop_time;
+	clock_gettime(CLOCK_MONOTONIC, &stop_time);
+	long double elapsed_sec = (
+			(stop_time.tv_sec - report_reader_start_time.tv_sec)
+			+ (stop_time.tv_nsec - report_reader_start_time.tv_nsec)
+				/ NSEC_SEC_RATIO);
+	for (int i = 0; i < NUM_OF_HIDRAW_REPORT_QUEUES; i++) {
+		const Report_Queue* queue = &report_queues[i];
+		if (queue->depth == 0) {
+			continue;
+		}
+		output(DEBUG,
+				"%s report queue: %u reports delivered, %u dropped, "
+				"%.0Lf reports/s.\n",
+				HIDRAW_REPORT_QUEUE_NAMES[i], queue->delivered, queue->dropped,
+				elapsed_sec > 0 ? queue->delivered / elapsed_sec : 0);
+	}
+
+	if (num_reports_picked_up > 0) {
+		output(DEBUG,
+				"Report pickup latency: %.3Lf ms min, %.3Lf ms avg, %.3Lf ms "
+				"max, %.3Lf ms jitter.\n",
+				report_pickup_min_ms, report_pickup_ms / num_reports_picked_up,
+				report_pickup_max_ms,
+				report_pickup_max_ms - report_pickup_min_ms);
+	}
 
-	char stop_signal[] = "S";
-	write(self_pipe_fd[SELF_PIPE_WRITE], stop_signal, 2);
+	if (num_reports_sent > 0) {
+		output(DEBUG, "Sent %u reports to %s, %.1Lf us per report.\n",
+				num_reports_sent, hidraw_sysfs_node_file,
+				report_send_time_us / num_reports_sent);
+	}
 
-	pthread_join(report_reader_tid, NULL);
+	/*
+	 * The report reader thread cancels its posted reads and reaps their
+	 * completions before it exits. If that failed the kernel may still write
+	 * into the report slab, so it is leaked rather than freed.
+	 */
+	exit_uring(&report_uring);
+	exit_uring(&send_uring);
+	uring_active = false;
 
-	for (int i = 0; i < REPORT_BUFFER_SIZE; i++) {
-		free(report_buffer[i].report.data);
-		report_buffer[i].report.data = NULL;
-		report_buffer[i].ready = false;
+	if (uring_reads_in_flight > 0) {
+		output(ERROR,
+				"%s: %u io_uring reads are still in flight. Leaking the "
+				"report slab.\n", __func__, uring_reads_in_flight);
+		uring_reads_in_flight = 0;
+	} else {
+		free(report_slab);
+	}
+	report_slab = NULL;
+	free(report_slots);
+	report_slots = NULL;
+	free(report_queue_entries);
+	report_queue_entries = NULL;
+	borrowed_queue = NULL;
+
+	if (hidraw0_open) {
+		close(hidraw0_fd);
+		hidraw0_open = false;
 	}
 
-	close(hidraw0_fd);
-	hidraw0_open = false;
-	close(self_pipe_fd[SELF_PIPE_READ]);
-	close(self_pipe_fd[SELF_PIPE_WRITE]);
+	int* event_fds[] = { &reactor_epoll_fd, &stop_event_fd, &deadline_timer_fd };
+	for (int i = 0; i < sizeof(event_fds) / sizeof(event_fds[0]); i++) {
+		if (*event_fds[i] >= 0) {
+			close(*event_fds[i]);
+			*event_fds[i] = -1;
+		}
+	}
+	reactor_num_sources = 0;
 
 	return EXIT_SUCCESS;
 }
 
-static Poll_Status _consume_report(HID_Report_ID target_report_id,
-		uint* next_victim_report_index, bool* more_reports)
+/*
+ * Cancels every read posted on the report ring and reaps completions until
+ * none of them is left in flight, so that the kernel no longer writes into
+ * the report slab. Reads that complete before their cancellation are simply
+ * discarded.
+ */
+static void _cancel_uring_reads()
 {
-	Poll_Status read_status = _read_report(
-			&report_buffer[*next_victim_report_index].report);
-	if (read_status != POLL_STATUS_GOT_DATA) {
-		return read_status;
+	struct io_uring_cqe* cqe;
+
+	for (uint i = 0; i < num_reader_slots; i++) {
+		struct io_uring_sqe* sqe = get_uring_sqe(&report_uring);
+		if (sqe == NULL) {
+			if (submit_uring(&report_uring, 0) < 0
+					|| (sqe = get_uring_sqe(&report_uring)) == NULL) {
+				break;
+			}
+		}
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->fd = -1;
+		sqe->addr = i;
+		sqe->user_data = HIDRAW_URING_CANCEL_USER_DATA;
 	}
 
-	pthread_mutex_lock(&report_buffer_mutex);
+	if (submit_uring(&report_uring, 0) < 0) {
+		output(ERROR, "%s: Failed to cancel the reads posted to %s. %s [%d]\n",
+				__func__, hidraw_sysfs_node_file, strerror(errno), errno);
+		return;
+	}
 
-	uint8_t report_id = report_buffer[*next_victim_report_index].report.data[
-												HID_INPUT_REPORT_ID_BYTE_INDEX];
-	read_status = (
-			(target_report_id == HID_REPORT_ID_ANY
-					|| target_report_id == report_id)
-					? POLL_STATUS_GOT_DATA : POLL_STATUS_SKIP);
-
-	if (read_status == POLL_STATUS_GOT_DATA) {
-		const HID_Input_PIP3_Response* input_report = (
-				(HID_Input_PIP3_Response*)
-				report_buffer[*next_victim_report_index].report.data);
-
-		*more_reports = (
-			(
-				   input_report->report_id == HID_REPORT_ID_SOLICITED_RESPONSE
-				|| input_report->report_id == HID_REPORT_ID_UNSOLICITED_RESPONSE
-			) ? input_report->more_reports : false
-		);
-		report_buffer[*next_victim_report_index].ready = true;
-
-		*next_victim_report_index = (
-				(*next_victim_report_index + 1) % REPORT_BUFFER_SIZE);
-		report_buffer_count++;
-		if (*next_victim_report_index
-				== report_buffer_least_recent_index) {
-			report_buffer_count--;
-			report_buffer_least_recent_index = (
-					(report_buffer_least_recent_index + 1)
-					% REPORT_BUFFER_SIZE);
+	while (uring_reads_in_flight > 0) {
+		cqe = peek_uring_cqe(&report_uring);
+		if (cqe == NULL) {
+			if (submit_uring(&report_uring, 1) < 0) {
+				output(ERROR,
+						"%s: Failed to wait for the reads posted to %s. "
+						"%s [%d]\n", __func__, hidraw_sysfs_node_file,
+						strerror(errno), errno);
+				return;
+			}
+			continue;
+		}
+
+		if (cqe->user_data != HIDRAW_URING_CANCEL_USER_DATA) {
+			uring_reads_in_flight--;
 		}
+		seen_uring_cqe(&report_uring);
 	}
+}
 
-	pthread_mutex_unlock(&report_buffer_mutex);
+static Poll_Status _drain_hidraw_reports(Reactor_Source* source)
+{
+	bool published = false;
+
+	while (1) {
+		ReportData* report = &report_slots[reader_slot];
+
+		int read_rc = read(source->fd, report->data, report->max_len);
+		if (read_rc < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			} else if (errno == EINTR) {
+				continue;
+			}
+			output(ERROR, "%s: Failed to read from %s. %s [%d]\n", __func__,
+					hidraw_sysfs_node_file, strerror(errno), errno);
+			return POLL_STATUS_ERROR;
+		}
+		report->len = read_rc;
+		clock_gettime(CLOCK_MONOTONIC, &report->timestamp);
+
+		if (_publish_report(&reader_slot)) {
+			published = true;
+		}
+	}
+
+	if (published && __atomic_load_n(&consumer_waiting, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&report_buffer_mutex);
+		pthread_cond_signal(&report_buffer_cond);
+		pthread_mutex_unlock(&report_buffer_mutex);
+	}
 
-	return read_status;
+	return POLL_STATUS_GOT_DATA;
+}
+
+static Report_Queue* _find_ready_queue(HID_Report_ID report_id)
+{
+	for (int i = 0; i < NUM_OF_HIDRAW_REPORT_QUEUES; i++) {
+		Report_Queue* queue = &report_queues[i];
+
+		if (report_id != HID_REPORT_ID_ANY && i != _get_report_queue(report_id)) {
+			continue;
+		}
+
+		if (__atomic_load_n(&queue->head, __ATOMIC_SEQ_CST)
+				!= __atomic_load_n(&queue->tail, __ATOMIC_RELAXED)) {
+			return queue;
+		}
+	}
+
+	return NULL;
 }
 
 #define AVG_DELAY_BETWEEN_CMD_AND_RSP 5 
@@ -605,6 +1098,47 @@ RETURN:
 	return max_input_len;
 }
 
+static int _get_max_lens_from_rpt_desc(
+		const struct hidraw_report_descriptor* rpt_desc, int* max_input_len,
+		int* max_output_len)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	HID_Report_Sizes* sizes = malloc(sizeof(HID_Report_Sizes));
+	int rc = EXIT_FAILURE;
+
+	if (sizes == NULL) {
+		output(ERROR, "%s: Memory allocation failed.\n", __func__);
+		return EXIT_FAILURE;
+	}
+
+	if (EXIT_SUCCESS != parse_hid_report_descriptor(rpt_desc->value,
+			rpt_desc->size, sizes)) {
+		goto RETURN;
+	}
+
+	if (0 == get_hid_report_len(sizes, HID_REPORT_TYPE_OUTPUT,
+					HID_REPORT_ID_COMMAND)
+			|| 0 == get_hid_report_len(sizes, HID_REPORT_TYPE_INPUT,
+					HID_REPORT_ID_SOLICITED_RESPONSE)) {
+		output(DEBUG, "The Report Descriptor does not describe the PIP3 "
+				"command and response reports.\n");
+		goto RETURN;
+	}
+
+	*max_input_len = get_max_hid_report_len(sizes, HID_REPORT_TYPE_INPUT) + 2;
+	*max_output_len = get_max_hid_report_len(sizes, HID_REPORT_TYPE_OUTPUT)
+			+ 2;
+	output(DEBUG, "Max HID input report length: %d bytes.\n",
+			*max_input_len);
+	output(DEBUG, "Max HID output report length: %d bytes.\n",
+			*max_output_len);
+	rc = EXIT_SUCCESS;
+
+RETURN:
+	free(sizes);
+	return rc;
+}
+
 static int _get_max_output_len()
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
@@ -640,105 +1174,567 @@ static int _get_max_output_len()
 	return max_output_len;
 }
 
-static Poll_Status _read_report(ReportData* report)
+static HIDRAW_Report_Queue _get_report_queue(HID_Report_ID report_id)
 {
-	int read_rc;
-	fd_set read_set;
-	int select_rc;
+	switch (report_id) {
+	case HID_REPORT_ID_SOLICITED_RESPONSE:
+		return HIDRAW_REPORT_QUEUE_SOLICITED;
+	case HID_REPORT_ID_UNSOLICITED_RESPONSE:
+		return HIDRAW_REPORT_QUEUE_UNSOLICITED;
+	case HID_REPORT_ID_FINGER:
+	case HID_REPORT_ID_STYLUS:
+	case HID_REPORT_ID_VENDOR_FINGER:
+	case HID_REPORT_ID_VENDOR_STYLUS:
+		return HIDRAW_REPORT_QUEUE_TOUCH;
+	default:
+		return HIDRAW_REPORT_QUEUE_OTHER;
+	}
+}
+
+static Poll_Status _handle_deadline_timer(Reactor_Source* source)
+{
+	uint64_t expirations;
+
+	/*
+	 * The consumer (re)arms the timer while holding the mutex, which also
+	 * resets the expiration count, so a successful read here always belongs
+	 * to the deadline that is currently armed.
+	 */
+	pthread_mutex_lock(&report_buffer_mutex);
+	if (read(source->fd, &expirations, sizeof(expirations))
+			== sizeof(expirations)) {
+		deadline_expired = true;
+		pthread_cond_broadcast(&report_buffer_cond);
+	}
+	pthread_mutex_unlock(&report_buffer_mutex);
+
+	return POLL_STATUS_SKIP;
+}
+
+static Poll_Status _handle_stop_event(Reactor_Source* source)
+{
+	output(DEBUG, "Got signal to stop report reader thread.\n");
+	return POLL_STATUS_TIMEOUT;
+}
+
+static void _format_detected_hidraw_node(const char* node_name,
+		char* sysfs_node_file, size_t sysfs_node_file_size)
+{
+	snprintf(sysfs_node_file, sysfs_node_file_size, "/dev/%s", node_name);
+	output(INFO, "Detected HIDRAW sysfs node = '%s'\n", sysfs_node_file);
+}
+
+static int _match_hidraw_uevent(const char* node_name, int vendor_id,
+		int product_id)
+{
+	char uevent_file[PATH_MAX];
+	char line[HIDRAW_UEVENT_LINE_MAX_STRLEN];
+	uint bus;
+	uint vendor;
+	uint product;
+	int rc = EXIT_FAILURE;
+
+	snprintf(uevent_file, sizeof(uevent_file), "%s/%s/device/uevent",
+			HIDRAW_SYSFS_CLASS_DIR, node_name);
+
+	FILE* fptr = fopen(uevent_file, "r");
+	if (fptr == NULL) {
+		output(DEBUG, "Failed to open %s. %s [%d]\n", uevent_file,
+				strerror(errno), errno);
+		return EXIT_FAILURE;
+	}
+
+	while (fgets(line, sizeof(line), fptr) != NULL) {
+		if (3 != sscanf(line, "HID_ID=%x:%x:%x", &bus, &vendor, &product)) {
+			continue;
+		}
+
+		output(DEBUG, "Detected device info for %s VID = 0x%04X, PID = "
+				"0x%04X\n", node_name, vendor, product);
+		if (vendor == vendor_id
+				&& (product_id == HID_PRODUCT_ID_ANY || product == product_id)) {
+			rc = EXIT_SUCCESS;
+		}
+		break;
+	}
+
+	fclose(fptr);
+	return rc;
+}
+
+static bool _pop_free_slot(uint* slot)
+{
+	uint tail = free_slot_ring.tail;
+
+	if (__atomic_load_n(&free_slot_ring.head, __ATOMIC_ACQUIRE) == tail) {
+		return false;
+	}
+
+	*slot = free_slot_ring.entries[tail & (free_slot_ring.depth - 1)];
+	__atomic_store_n(&free_slot_ring.tail, tail + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+static int _post_uring_read(uint index)
+{
+	struct io_uring_sqe* sqe = get_uring_sqe(&report_uring);
+	uint slot = uring_read_slots[index];
+
+	if (sqe == NULL) {
+		output(ERROR, "%s: The io_uring submission queue is full.\n",
+				__func__);
+		return EXIT_FAILURE;
+	}
+
+	prep_uring_rw(sqe, IORING_OP_READ, hidraw0_fd, report_slots[slot].data,
+			report_slots[slot].max_len, index);
+	uring_reads_in_flight++;
+	return EXIT_SUCCESS;
+}
+
+/*
+ * Hands the report in the given slot to the queue for its report ID and
+ * replaces the slot with a free one. Returns false, leaving the slot with the
+ * reader, when the report was discarded.
+ */
+static bool _publish_report(uint* slot)
+{
+	uint8_t report_id = report_slots[*slot].data[HID_INPUT_REPORT_ID_BYTE_INDEX];
+	Report_Queue* queue = &report_queues[_get_report_queue(report_id)];
+	if (queue->depth == 0) {
+		return false;
+	}
+
+	uint head = queue->head;
+	uint next_slot;
+	if (head - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) == queue->depth
+			|| !_pop_free_slot(&next_slot)) {
+		__atomic_add_fetch(&queue->dropped, 1, __ATOMIC_RELAXED);
+		output(DEBUG, "Report queue full. Dropped report with ID 0x%02X.\n",
+				report_id);
+		return false;
+	}
+
+	queue->entries[head & (queue->depth - 1)] = *slot;
+	__atomic_store_n(&queue->head, head + 1, __ATOMIC_SEQ_CST);
+	queue->delivered++;
+	*slot = next_slot;
+	return true;
+}
+
+static void _push_free_slot(uint slot)
+{
+	uint head = free_slot_ring.head;
+
+	free_slot_ring.entries[head & (free_slot_ring.depth - 1)] = slot;
+	__atomic_store_n(&free_slot_ring.head, head + 1, __ATOMIC_RELEASE);
+}
+
+static int _reactor_add_source(int fd,
+		Poll_Status (*on_readable)(Reactor_Source* source))
+{
+	if (reactor_num_sources >= REACTOR_MAX_SOURCES) {
+		output(ERROR, "%s: Cannot watch more than %d file descriptors.\n",
+				__func__, REACTOR_MAX_SOURCES);
+		return EXIT_FAILURE;
+	}
 
-	FD_ZERO(&read_set);
-	FD_SET(hidraw0_fd, &read_set);
-	FD_SET(self_pipe_fd[SELF_PIPE_READ], &read_set);
+	Reactor_Source* source = &reactor_sources[reactor_num_sources];
+	source->fd = fd;
+	source->on_readable = on_readable;
 
-	select_rc = select(self_pipe_fd[SELF_PIPE_READ] + 1, &read_set, NULL, NULL,
-			NULL);
-	if (select_rc == -1) {
+	struct epoll_event event = {
+			.events   = EPOLLIN,
+			.data.ptr = source
+	};
+	if (epoll_ctl(reactor_epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		output(ERROR, "%s: Failed to watch file descriptor %d. %s [%d]\n",
+				__func__, fd, strerror(errno), errno);
+		return EXIT_FAILURE;
+	}
+
+	reactor_num_sources++;
+	return EXIT_SUCCESS;
+}
+
+static Poll_Status _reactor_dispatch()
+{
+	struct epoll_event events[REACTOR_MAX_SOURCES];
+	Poll_Status rc = POLL_STATUS_SKIP;
+
+	int num_events = epoll_wait(reactor_epoll_fd, events, REACTOR_MAX_SOURCES,
+			-1);
+	if (num_events < 0) {
+		if (errno == EINTR) {
+			return POLL_STATUS_SKIP;
+		}
 		output(ERROR, "%s: A problem occurred while trying to read from %s. "
 				"%s [%d]\n", __func__, hidraw_sysfs_node_file, strerror(errno),
 				errno);
 		return POLL_STATUS_ERROR;
-	} else if (select_rc == 0) {
-		output(DEBUG, "Polling timed-out for incoming data.\n");
-		return POLL_STATUS_TIMEOUT;
 	}
 
-	if (stop_reading) {
-		output(DEBUG, "Got signal to stop report reader thread.\n");
-		return POLL_STATUS_TIMEOUT;
+	for (int i = 0; i < num_events; i++) {
+		Reactor_Source* source = (Reactor_Source*) events[i].data.ptr;
+		Poll_Status source_rc = source->on_readable(source);
+		if (source_rc != POLL_STATUS_GOT_DATA
+				&& source_rc != POLL_STATUS_SKIP) {
+			return source_rc;
+		} else if (source_rc == POLL_STATUS_GOT_DATA) {
+			rc = POLL_STATUS_GOT_DATA;
+		}
 	}
 
-	read_rc = read(hidraw0_fd, report->data, report->max_len);
-	if (read_rc < 0) {
-		output(ERROR, "%s: Failed to read from %s. %s [%d]\n", __func__,
+	return rc;
+}
+
+static Poll_Status _reap_uring_reports(Reactor_Source* source)
+{
+	struct io_uring_cqe* cqe;
+	bool published = false;
+
+	while ((cqe = peek_uring_cqe(&report_uring)) != NULL) {
+		uint index = (uint) cqe->user_data;
+		uint slot = uring_read_slots[index];
+		int res = cqe->res;
+		seen_uring_cqe(&report_uring);
+		uring_reads_in_flight--;
+
+		if (res < 0 && res != -EINTR && res != -EAGAIN) {
+			output(ERROR, "%s: Failed to read from %s. %s [%d]\n", __func__,
+					hidraw_sysfs_node_file, strerror(-res), -res);
+			return POLL_STATUS_ERROR;
+		} else if (res >= 0) {
+			report_slots[slot].len = res;
+			clock_gettime(CLOCK_MONOTONIC, &report_slots[slot].timestamp);
+			if (_publish_report(&slot)) {
+				published = true;
+			}
+		}
+
+		uring_read_slots[index] = slot;
+		if (EXIT_SUCCESS != _post_uring_read(index)) {
+			return POLL_STATUS_ERROR;
+		}
+	}
+
+	if (submit_uring(&report_uring, 0) < 0) {
+		output(ERROR, "%s: Failed to post reads to %s. %s [%d]\n", __func__,
 				hidraw_sysfs_node_file, strerror(errno), errno);
 		return POLL_STATUS_ERROR;
 	}
-	report->len = read_rc;
+
+	if (published && __atomic_load_n(&consumer_waiting, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&report_buffer_mutex);
+		pthread_cond_signal(&report_buffer_cond);
+		pthread_mutex_unlock(&report_buffer_mutex);
+	}
+
 	return POLL_STATUS_GOT_DATA;
 }
 
 static void* _report_reader_thread(void* arg)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
-	HID_Report_ID report_id = *((HID_Report_ID*) arg);
-	uint next_victim_report_index = 0;
 	Poll_Status read_status = POLL_STATUS_GOT_DATA;
-	bool more_reports = false;
 
-	report_reader_thread_status = REPORT_READER_THREAD_STATUS_ACTIVE;
+	clock_gettime(CLOCK_MONOTONIC, &report_reader_start_time);
+
+	if (uring_active) {
+		uring_reads_in_flight = 0;
+		for (uint i = 0; i < num_reader_slots; i++) {
+			uring_read_slots[i] = i;
+			if (EXIT_SUCCESS != _post_uring_read(i)) {
+				read_status = POLL_STATUS_ERROR;
+			}
+		}
 
-	do {
-		memset(report_buffer[next_victim_report_index].report.data, 0,
-				report_buffer[next_victim_report_index].report.max_len);
+		if (read_status != POLL_STATUS_ERROR
+				&& submit_uring(&report_uring, 0) < 0) {
+			output(ERROR, "%s: Failed to post reads to %s. %s [%d]\n",
+					__func__, hidraw_sysfs_node_file, strerror(errno), errno);
+			read_status = POLL_STATUS_ERROR;
+		}
+	}
 
-		read_status = _consume_report(report_id, &next_victim_report_index,
-				&more_reports);
-	} while ((read_status == POLL_STATUS_GOT_DATA
+	/*
+	 * Failing to post the first reads is reported as an immediate exit, so
+	 * that the thread starting the reader can fall back to epoll.
+	 */
+	__atomic_store_n(&report_reader_thread_status,
+			(read_status == POLL_STATUS_ERROR)
+				? REPORT_READER_THREAD_STATUS_EXIT
+				: REPORT_READER_THREAD_STATUS_ACTIVE,
+			__ATOMIC_RELEASE);
+
+	while ((read_status == POLL_STATUS_GOT_DATA
 			|| read_status == POLL_STATUS_SKIP)
 			&& report_reader_thread_status
-				== REPORT_READER_THREAD_STATUS_ACTIVE);
+				== REPORT_READER_THREAD_STATUS_ACTIVE) {
+		read_status = _reactor_dispatch();
+	}
+
+	if (uring_active) {
+		_cancel_uring_reads();
+	}
 
 	pthread_mutex_lock(&report_buffer_mutex);
 	report_read_status = (
-			(read_status != POLL_STATUS_ERROR && report_buffer_count > 0)
+			(read_status != POLL_STATUS_ERROR
+				&& _find_ready_queue(HID_REPORT_ID_ANY) != NULL)
 			? POLL_STATUS_GOT_DATA : read_status);
-	report_reader_thread_status = REPORT_READER_THREAD_STATUS_EXIT;
+	__atomic_store_n(&report_reader_thread_status,
+			REPORT_READER_THREAD_STATUS_EXIT, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&report_buffer_cond);
 	pthread_mutex_unlock(&report_buffer_mutex);
 
 	output(DEBUG, "%s: Leaving.\n", __func__);
 	pthread_exit(NULL);
 }
 
-static int _try_hidraw_sysfs_node(char* sysfs_node_file, int vendor_id,
-		int product_id)
+static int _start_report_reader(HID_Report_ID report_id, bool use_io_uring)
 {
+	output(DEBUG, "%s: Starting.\n", __func__);
 	int rc = EXIT_FAILURE;
-	struct hidraw_devinfo dev_info;
+	HID_Descriptor hid_desc;
+	struct timespec setup_start_time;
+	struct timespec ready_time;
 
-	int fd = open(sysfs_node_file, O_RDWR | O_NONBLOCK);
-	if (fd < 0) {
+	clock_gettime(CLOCK_MONOTONIC, &setup_start_time);
+	report_reader_thread_status = REPORT_READER_THREAD_STATUS_NOT_STARTED;
+	consumer_waiting = false;
+	borrowed_queue = NULL;
+	num_reports_sent = 0;
+	report_send_time_us = 0;
+	num_reports_picked_up = 0;
+	report_pickup_ms = 0;
+
+	if (EXIT_SUCCESS != get_hid_descriptor_from_hidraw(&hid_desc)) {
+		rc = EXIT_FAILURE;
+		goto RETURN;
+	}
+
+	hid_output_report_size = hid_desc.max_output_len - 2;
+	hid_input_report_size = hid_desc.max_input_len - 2;
+
+	uring_active = false;
+	if (use_io_uring) {
+		if (EXIT_SUCCESS == init_uring(&report_uring,
+						HIDRAW_URING_POSTED_READS)
+				&& EXIT_SUCCESS == init_uring(&send_uring,
+						HIDRAW_URING_SEND_DEPTH)
+				&& (report_uring.features & IORING_FEAT_FAST_POLL)) {
+			uring_active = true;
+		} else {
+			output(WARNING,
+					"io_uring is not supported by this kernel. Falling back "
+					"to the epoll based HIDRAW transport.\n");
+			exit_uring(&report_uring);
+			exit_uring(&send_uring);
+		}
+	}
+
+	/*
+	 * io_uring fails reads on O_NONBLOCK files with EAGAIN instead of waiting
+	 * for them to become readable, so the node is only opened non-blocking
+	 * for the epoll transport.
+	 */
+	hidraw0_fd = open(hidraw_sysfs_node_file,
+			O_RDWR | (uring_active ? 0 : O_NONBLOCK));
+	if (hidraw0_fd < 0) {
 		output(ERROR, "%s: Failed to open %s. %s [%d]\n", __func__,
-				sysfs_node_file, strerror(errno), errno);
-		return EXIT_FAILURE;
+				hidraw_sysfs_node_file, strerror(errno), errno);
+		rc = EXIT_FAILURE;
+		goto RETURN;
 	}
+	hidraw0_open = true;
 
-	if (ioctl(fd, HIDIOCGRAWINFO, &dev_info) < 0) {
+	reactor_num_sources = 0;
+	reactor_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	stop_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	deadline_timer_fd = timerfd_create(CLOCK_MONOTONIC,
+			TFD_NONBLOCK | TFD_CLOEXEC);
+	if (reactor_epoll_fd < 0 || stop_event_fd < 0 || deadline_timer_fd < 0) {
 		output(ERROR,
-				"%s: Failed to read the raw device info from %s. "
+				"%s: Failed to set up the report reader event loop. %s [%d]\n",
+				__func__, strerror(errno), errno);
+		rc = EXIT_FAILURE;
+		goto RETURN;
+	}
+
+	if (EXIT_SUCCESS != (uring_active
+					? _reactor_add_source(report_uring.fd, _reap_uring_reports)
+					: _reactor_add_source(hidraw0_fd, _drain_hidraw_reports))
+			|| EXIT_SUCCESS != _reactor_add_source(stop_event_fd,
+					_handle_stop_event)
+			|| EXIT_SUCCESS != _reactor_add_source(deadline_timer_fd,
+					_handle_deadline_timer)) {
+		rc = EXIT_FAILURE;
+		goto RETURN;
+	}
+
+	deadline_expired = false;
+	pthread_cond_init(&report_buffer_cond, NULL);
+
+	/*
+	 * Only the queue of the requested report ID is enabled, unless any
+	 * report ID was requested. The report reader thread always owns one extra
+	 * slot per outstanding read to read the next report into.
+	 */
+	num_reader_slots = uring_active ? HIDRAW_URING_POSTED_READS : 1;
+	num_report_slots = num_reader_slots;
+	for (int i = 0; i < NUM_OF_HIDRAW_REPORT_QUEUES; i++) {
+		memset(&report_queues[i], 0, sizeof(report_queues[i]));
+		if (report_id == HID_REPORT_ID_ANY
+				|| i == _get_report_queue(report_id)) {
+			report_queues[i].depth = report_queue_depths[i];
+			num_report_slots += report_queues[i].depth;
+		}
+	}
+
+	memset(&free_slot_ring, 0, sizeof(free_slot_ring));
+	free_slot_ring.depth = 1;
+	while (free_slot_ring.depth < num_report_slots) {
+		free_slot_ring.depth <<= 1;
+	}
+
+	size_t slot_stride = ((hid_input_report_size + CACHE_LINE_SIZE - 1)
+			/ CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+	size_t slab_size = num_report_slots * slot_stride;
+
+	report_slots = calloc(num_report_slots, sizeof(ReportData));
+	report_queue_entries = calloc(num_report_slots + free_slot_ring.depth,
+			sizeof(uint));
+	if (NULL == report_slots || NULL == report_queue_entries
+			|| 0 != posix_memalign((void**) &report_slab, CACHE_LINE_SIZE,
+					slab_size)) {
+		output(ERROR, "%s: Memory allocation failed.\n", __func__);
+		report_slab = NULL;
+		rc = EXIT_FAILURE;
+		goto RETURN;
+	}
+
+	for (uint i = 0; i < num_report_slots; i++) {
+		report_slots[i].data = &report_slab[i * slot_stride];
+		report_slots[i].max_len = hid_input_report_size;
+		report_slots[i].len = 0;
+	}
+
+	uint* entries = report_queue_entries;
+	for (int i = 0; i < NUM_OF_HIDRAW_REPORT_QUEUES; i++) {
+		report_queues[i].entries = entries;
+		entries += report_queues[i].depth;
+	}
+	free_slot_ring.entries = entries;
+
+	reader_slot = 0;
+	for (uint i = num_reader_slots; i < num_report_slots; i++) {
+		_push_free_slot(i);
+	}
+
+	if (0 != pthread_create(&report_reader_tid, NULL, _report_reader_thread,
+			NULL)) { 
+		output(ERROR,
+				"%s: Failed to start thread for reading reports from %s. "
 				"%s [%d]\n",
 				__func__, hidraw_sysfs_node_file, strerror(errno), errno);
 		rc = EXIT_FAILURE;
 		goto RETURN;
 	}
 
-	output(INFO, "Detected device info for %s VID = 0x%04X, PID = 0x%04X\n",
-			sysfs_node_file, dev_info.vendor, dev_info.product);
+	/*
+	 * Missing privileges only cost latency, so the reader keeps running with
+	 * the default scheduling if these fail.
+	 */
+	if (report_reader_rt_priority != SCHED_RT_PRIORITY_NONE) {
+		set_thread_rt_priority(report_reader_tid, report_reader_rt_priority);
+	}
+	if (report_reader_cpu != SCHED_CPU_ANY) {
+		set_thread_cpu_affinity(report_reader_tid, report_reader_cpu);
+	}
+
+	while (__atomic_load_n(&report_reader_thread_status, __ATOMIC_ACQUIRE)
+			== REPORT_READER_THREAD_STATUS_NOT_STARTED)
+			sleep_ms(1);
 
-	if (vendor_id == dev_info.vendor && product_id == dev_info.product) {
-		rc = init_hidraw_api(sysfs_node_file, NULL);
+	if (__atomic_load_n(&report_reader_thread_status, __ATOMIC_ACQUIRE)
+			== REPORT_READER_THREAD_STATUS_EXIT) {
+		if (uring_active) {
+			output(WARNING,
+					"Failed to post the io_uring reads. Falling back to the "
+					"epoll based HIDRAW transport.\n");
+			stop_hidraw_report_reader();
+			return _start_report_reader(report_id, false);
+		}
+
+		output(ERROR, "%s: The report reader thread exited on start-up.\n",
+				__func__);
+		rc = EXIT_FAILURE;
+		goto RETURN;
 	}
 
+	clock_gettime(CLOCK_MONOTONIC, &ready_time);
+	output(DEBUG,
+			"Report reader started in %.3Lf ms with %u report slots "
+			"(%lu byte slab) using %s.\n",
+			((ready_time.tv_sec - setup_start_time.tv_sec) * 1e3L
+			+ (ready_time.tv_nsec - setup_start_time.tv_nsec) / 1e6L),
+			num_report_slots, slab_size, uring_active ? "io_uring" : "epoll");
+
+	rc = EXIT_SUCCESS;
+
 RETURN:
-	close(fd);
+	if (rc != EXIT_SUCCESS) {
+		stop_hidraw_report_reader();
+	}
+
+	return rc;
+}
+
+static Poll_Status _wait_for_queue_data(HID_Report_ID report_id,
+		Report_Queue** queue, bool apply_timeout, long double timeout_val)
+{
+	Poll_Status rc = POLL_STATUS_GOT_DATA;
+	struct itimerspec deadline = { 0 };
+
+	pthread_mutex_lock(&report_buffer_mutex);
+	if (apply_timeout) {
+		get_monotonic_deadline(&deadline.it_value, timeout_val);
+		if (timerfd_settime(deadline_timer_fd, TFD_TIMER_ABSTIME, &deadline,
+				NULL) < 0) {
+			output(ERROR, "%s: Failed to arm the deadline timer. %s [%d]\n",
+					__func__, strerror(errno), errno);
+			pthread_mutex_unlock(&report_buffer_mutex);
+			return POLL_STATUS_ERROR;
+		}
+		deadline_expired = false;
+	}
+
+	__atomic_store_n(&consumer_waiting, true, __ATOMIC_SEQ_CST);
+	while ((*queue = _find_ready_queue(report_id)) == NULL) {
+		if (__atomic_load_n(&report_reader_thread_status, __ATOMIC_ACQUIRE)
+				!= REPORT_READER_THREAD_STATUS_ACTIVE) {
+			if ((*queue = _find_ready_queue(report_id)) == NULL) {
+				rc = (report_read_status == POLL_STATUS_GOT_DATA)
+						? POLL_STATUS_SKIP : report_read_status;
+			}
+			break;
+		}
+
+		if (apply_timeout && deadline_expired) {
+			rc = POLL_STATUS_TIMEOUT;
+			break;
+		}
+
+		pthread_cond_wait(&report_buffer_cond, &report_buffer_mutex);
+	}
+	__atomic_store_n(&consumer_waiting, false, __ATOMIC_RELAXED);
+
+	if (apply_timeout) {
+		struct itimerspec disarm = { 0 };
+		timerfd_settime(deadline_timer_fd, 0, &disarm, NULL);
+	}
+	pthread_mutex_unlock(&report_buffer_mutex);
+
 	return rc;
 }
@@ -6,32 +6,73 @@
 #define HIDRAW_H_
 
 #include <fcntl.h>
+#include <limits.h>
 #include <linux/hidraw.h>
 #include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
+#include <sys/timerfd.h>
 #include <sys/wait.h>
 #include "../channel/channel.h"
+#include "../crc16_ccitt.h"
 #include "../file/ptlib_file.h"
 #include "../logging.h"
 #include "../report_data.h"
+#include "../sched/ptlib_sched.h"
 #include "../sleep/ptlib_sleep.h"
+#include "../uring/ptlib_uring.h"
 #include "hid.h"
+#include "hid_desc_cache.h"
+#include "hid_report_desc.h"
 
 #define HIDRAW0_SYSFS_NODE_FILE "/dev/hidraw0"
+#define HID_PRODUCT_ID_ANY -1
+
+#define HIDRAW_REPORT_BUFFER_DEFAULT_DEPTH 256
+#define HIDRAW_REPORT_BUFFER_MAX_DEPTH     4096
+#define HIDRAW_TOUCH_REPORT_QUEUE_DEPTH    64
+#define HIDRAW_OTHER_REPORT_QUEUE_DEPTH    16
+
+typedef enum {
+	HIDRAW_REPORT_QUEUE_SOLICITED,
+	HIDRAW_REPORT_QUEUE_UNSOLICITED,
+	HIDRAW_REPORT_QUEUE_TOUCH,
+	HIDRAW_REPORT_QUEUE_OTHER,
+	NUM_OF_HIDRAW_REPORT_QUEUES
+} HIDRAW_Report_Queue;
+
+extern char* HIDRAW_REPORT_QUEUE_NAMES[NUM_OF_HIDRAW_REPORT_QUEUES];
 
 extern Channel hidraw_channel;
+extern Channel hidraw_uring_channel;
 
-extern int auto_detect_hidraw_sysfs_node(int vendor_id, int product_id);
+extern int auto_detect_hidraw_sysfs_node(int vendor_id, int product_id,
+		bool use_cache, char* sysfs_node_file, size_t sysfs_node_file_size);
+extern Poll_Status borrow_report_from_hidraw(HID_Report_ID report_id,
+		ReportData** report, bool apply_timeout, long double timeout_val);
 extern void clear_hidraw_report_buffer();
 extern int get_hid_descriptor_from_hidraw(HID_Descriptor* hid_desc);
-extern Poll_Status get_report_from_hidraw(ReportData* report,
-		bool apply_timeout, long double timeout_val);
+extern const char* get_hidraw_sysfs_node_file();
+extern uint get_hidraw_report_drop_count(HID_Report_ID report_id);
+extern Poll_Status get_report_from_hidraw(HID_Report_ID report_id,
+		ReportData* report, bool apply_timeout, long double timeout_val);
 extern int get_report_descriptor_from_hidraw(ReportData* report);
 extern int init_hidraw_api(const char* sysfs_node_file,
 	const HID_Descriptor* hid_desc);
 extern int init_input_report(ReportData* report);
-extern int send_report_via_hidraw(const ReportData* report);
+extern void release_report_to_hidraw();
+extern int send_report_via_hidraw(ReportData* report);
+extern int send_report_via_hidraw_uring(ReportData* report);
+extern int send_reports_via_hidraw(ReportData* reports, uint num_reports);
+extern int send_reports_via_hidraw_uring(ReportData* reports,
+		uint num_reports);
+extern int set_hidraw_report_buffer_depth(uint depth);
+extern int set_hidraw_report_queue_depth(HIDRAW_Report_Queue queue,
+		uint depth);
+extern void set_hidraw_report_reader_sched(int rt_priority, int cpu);
 extern int start_hidraw_report_reader(HID_Report_ID report_id);
+extern int start_hidraw_uring_report_reader(HID_Report_ID report_id);
 extern int stop_hidraw_report_reader();
 
 #endif 
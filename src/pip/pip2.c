@@ -14,6 +14,18 @@
 
 #define TAG_BIT 1
 
+/*
+ * Room for a command response, a FILE_READ response and a FILE_WRITE command
+ * at the same time.
+ */
+#define ARENA_SIZE (2 * (PIP2_PAYLOAD_MAX_LEN + PIP_ARENA_ALIGNMENT) \
+		+ PIP2_FILE_WRITE_CMD_MAX_LEN)
+
+#define RSP_POLL_MIN_INTERVAL_US 100
+#define RSP_POLL_MAX_INTERVAL_US 2000
+
+#define FILE_WRITE_DATA_INDEX (sizeof(PIP2_Cmd_Header) + sizeof(uint8_t))
+
 char* PIP2_EXEC_NAMES[] = {
 		[PIP2_EXEC_ROM] = "ROM Bootloader EXEC",
 		[PIP2_EXEC_RAM] = "RAM Application EXEC"
@@ -39,7 +51,21 @@ static ChannelType active_channel_type = CHANNEL_TYPE_NONE;
 static int i2c_dev_fd = -1;
 static int i2c_bus;
 static int i2c_addr;
-
+static bool use_fixed_cmd_delay = false;
+static PIP_Write_Progress_Func file_write_progress = NULL;
+static void* file_write_progress_context = NULL;
+static uint num_rsp_polls;
+static PIP_Arena arena = { .base = NULL, .protocol = PIP_PROTOCOL_PIP2 };
+
+typedef struct {
+	uint8_t seq_num;
+	uint8_t file_handle;
+} PIP2_File_Write_Context;
+
+static uint16_t _calculate_pip2_file_write_crc(uint index,
+		const uint8_t* data, size_t len, void* context);
+static void _fill_pip2_file_write_header(uint8_t* cmd_data, size_t cmd_len,
+		uint8_t seq_num, uint8_t file_handle);
 static int _send_report_via_i2cdev(const ReportData* report);
 static Poll_Status _get_report_from_i2cdev(ReportData* report,
 		bool apply_timeout, long double timeout_val);
@@ -57,6 +83,9 @@ int do_pip2_command(ReportData* cmd, ReportData* rsp)
 	int rc;
 	Poll_Status read_rc;
 	ReportData rsp_report;
+	struct timespec cmd_start_time;
+	struct timespec cmd_sent_time;
+	struct timespec cmd_end_time;
 
 	cmd_header = (PIP2_Cmd_Header*) cmd->data;
 
@@ -72,7 +101,8 @@ int do_pip2_command(ReportData* cmd, ReportData* rsp)
 
 	rsp_report.data = NULL;
 	rsp_report.max_len = PIP2_PAYLOAD_MAX_LEN;
-	rsp_report.data = (uint8_t*) calloc(rsp_report.max_len, sizeof(uint8_t));
+	rsp_report.data = (uint8_t*) get_pip_arena_buffer(&arena,
+			rsp_report.max_len, false);
 	if (rsp_report.data == NULL) {
 		output(ERROR, "%s: Memory allocation failed. %s [%d].\n", __func__,
 				strerror(errno), errno);
@@ -81,20 +111,31 @@ int do_pip2_command(ReportData* cmd, ReportData* rsp)
 
 	output_debug_report(REPORT_DIRECTION_OUTGOING_TO_DUT, REPORT_FORMAT_PIP2,
 			PIP2_CMD_NAMES[cmd_header->cmd_id], REPORT_TYPE_COMMAND, cmd);
+	clock_gettime(CLOCK_MONOTONIC, &cmd_start_time);
 	rc = send_pip2_cmd_via_channel(cmd);
 	if (rc != EXIT_SUCCESS) {
 		goto RETURN;
 	}
+	clock_gettime(CLOCK_MONOTONIC, &cmd_sent_time);
 
-	if (cmd_header->cmd_id == PIP2_CMD_ID_FILE_IOCTL) {
-		sleep(FILE_IOCTL_ERASE_DELAY_BETWEEN_CMD_AND_RSP);
-	} else {
-		sleep_ms(AVG_DELAY_BETWEEN_CMD_AND_RSP);
+	long double rsp_timeout = MAX_TIMEOUT_BETWEEN_CMD_AND_RSP;
+	if (use_fixed_cmd_delay) {
+		if (cmd_header->cmd_id == PIP2_CMD_ID_FILE_IOCTL) {
+			sleep(FILE_IOCTL_ERASE_DELAY_BETWEEN_CMD_AND_RSP);
+		} else {
+			sleep_ms(AVG_DELAY_BETWEEN_CMD_AND_RSP);
+		}
+	} else if (cmd_header->cmd_id == PIP2_CMD_ID_FILE_IOCTL) {
+		rsp_timeout += FILE_IOCTL_ERASE_DELAY_BETWEEN_CMD_AND_RSP;
 	}
 
 	memset(rsp_report.data, 0, sizeof(rsp_report.max_len));
-	read_rc = get_pip2_rsp_via_channel(&rsp_report, true,
-			MAX_TIMEOUT_BETWEEN_CMD_AND_RSP);
+	num_rsp_polls = 0;
+	read_rc = get_pip2_rsp_via_channel(&rsp_report, true, rsp_timeout);
+	if (num_rsp_polls > 1) {
+		record_pip_cmd_retries(PIP_PROTOCOL_PIP2, cmd_header->cmd_id,
+				num_rsp_polls - 1);
+	}
 	switch (read_rc) {
 	case POLL_STATUS_GOT_DATA:
 		break;
@@ -102,6 +143,7 @@ int do_pip2_command(ReportData* cmd, ReportData* rsp)
 		output(ERROR,
 				"%s: Timed-Out waiting for PIP2 %s Response.\n",
 				__func__, PIP2_CMD_NAMES[cmd_header->cmd_id]);
+		record_pip_cmd(PIP_PROTOCOL_PIP2, cmd_header->cmd_id, 0, 0, 0, true);
 		rc = EXIT_FAILURE;
 		break;
 	case POLL_STATUS_ERROR:
@@ -160,8 +202,18 @@ int do_pip2_command(ReportData* cmd, ReportData* rsp)
 		}
 	}
 
+	/*
+	 * A PIP2 response is read in one transfer, so reassembly covers the
+	 * verification and copying of the response.
+	 */
+	clock_gettime(CLOCK_MONOTONIC, &cmd_end_time);
+	record_pip_cmd(PIP_PROTOCOL_PIP2, cmd_header->cmd_id,
+			get_timespec_diff_ms(&cmd_start_time, &cmd_sent_time),
+			get_timespec_diff_ms(&cmd_sent_time, &rsp_report.timestamp),
+			get_timespec_diff_ms(&rsp_report.timestamp, &cmd_end_time), false);
+
 RETURN:
-	free(rsp_report.data);
+	put_pip_arena_buffer(&arena, rsp_report.data);
 	return rc;
 }
 
@@ -215,6 +267,64 @@ int do_pip2_file_close_cmd(uint8_t seq_num, uint8_t file_handle,
 	return do_pip2_command(&cmd, &_rsp);
 }
 
+int do_pip2_file_ioctl_crc_cmd(uint8_t seq_num, uint8_t file_handle,
+		uint32_t offset, uint32_t len, PIP2_Rsp_Payload_FileIOCTL_FileCRC* rsp)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	if (rsp == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return EXIT_FAILURE;
+	} else if (seq_num > MAX_SEQ_NUM) {
+		output(ERROR,
+				"%s: The sequence number must be less <= 7 (%u was given).\n",
+				__func__, seq_num);
+		return EXIT_FAILURE;
+	}
+
+	uint16_t cmd_payload_len = sizeof(PIP2_Cmd_Payload_FileIOCTL_FileCRC) - 2;
+	PIP2_Cmd_Payload_FileIOCTL_FileCRC cmd_data = {
+			.header = {
+					.cmd_reg_lsb        = PIP2_CMD_REG_LSB,
+					.cmd_reg_msb        = PIP2_CMD_REG_MSB,
+					.payload_len_lsb    = cmd_payload_len & 0xFF,
+					.payload_len_msb    = cmd_payload_len >> 8,
+					.seq                = seq_num,
+					.tag                = TAG_BIT,
+					.reserved_section_1 = 0,
+					.cmd_id             = (uint8_t) PIP2_CMD_ID_FILE_IOCTL,
+					.resp               = 0
+			},
+			.file_handle = file_handle,
+			.ioctl_code  = (uint8_t) PIP2_IOCTL_CODE_FILE_CRC,
+			.offset      = {
+					offset & 0xFF, (offset >> 8) & 0xFF,
+					(offset >> 16) & 0xFF, offset >> 24
+			},
+			.len         = {
+					len & 0xFF, (len >> 8) & 0xFF, (len >> 16) & 0xFF, len >> 24
+			}
+	};
+	ReportData cmd = {
+			.data = (uint8_t*) &cmd_data,
+			.len  = sizeof(cmd_data)
+	};
+	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[2]),
+			cmd.len - 4);
+	cmd.data[cmd.len - 2] = cmd_crc >> 8;
+	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
+
+	ReportData _rsp = {
+			.data        = (uint8_t*) rsp,
+			.len         = 0,
+			.index       = 0,
+			.num_records = 0,
+			.max_len     = sizeof(PIP2_Rsp_Payload_FileIOCTL_FileCRC)
+	};
+
+	return do_pip2_command(&cmd, &_rsp);
+}
+
 int do_pip2_file_ioctl_erase_file_cmd(uint8_t seq_num, uint8_t file_handle,
 		PIP2_Rsp_Payload_FileIOCTL_EraseFile* rsp)
 {
@@ -266,6 +376,118 @@ int do_pip2_file_ioctl_erase_file_cmd(uint8_t seq_num, uint8_t file_handle,
 	return do_pip2_command(&cmd, &_rsp);
 }
 
+int do_pip2_file_ioctl_file_stats_cmd(uint8_t seq_num, uint8_t file_handle,
+		PIP2_Rsp_Payload_FileIOCTL_FileStats* rsp)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	if (rsp == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return EXIT_FAILURE;
+	} else if (seq_num > MAX_SEQ_NUM) {
+		output(ERROR,
+				"%s: The sequence number must be less <= 7 (%u was given).\n",
+				__func__, seq_num);
+		return EXIT_FAILURE;
+	}
+
+	uint16_t cmd_payload_len = sizeof(PIP2_Cmd_Payload_FileIOCTL_FileStats) - 2;
+	PIP2_Cmd_Payload_FileIOCTL_FileStats cmd_data = {
+			.header = {
+					.cmd_reg_lsb        = PIP2_CMD_REG_LSB,
+					.cmd_reg_msb        = PIP2_CMD_REG_MSB,
+					.payload_len_lsb    = cmd_payload_len & 0xFF,
+					.payload_len_msb    = cmd_payload_len >> 8,
+					.seq                = seq_num,
+					.tag                = TAG_BIT,
+					.reserved_section_1 = 0,
+					.cmd_id             = (uint8_t) PIP2_CMD_ID_FILE_IOCTL,
+					.resp               = 0
+			},
+			.file_handle = file_handle,
+			.ioctl_code  = (uint8_t) PIP2_IOCTL_CODE_FILE_STATS
+	};
+	ReportData cmd = {
+			.data = (uint8_t*) &cmd_data,
+			.len  = sizeof(cmd_data)
+	};
+	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[2]),
+			cmd.len - 4);
+	cmd.data[cmd.len - 2] = cmd_crc >> 8;
+	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
+
+	ReportData _rsp = {
+			.data        = (uint8_t*) rsp,
+			.len         = 0,
+			.index       = 0,
+			.num_records = 0,
+			.max_len     = sizeof(PIP2_Rsp_Payload_FileIOCTL_FileStats)
+	};
+
+	return do_pip2_command(&cmd, &_rsp);
+}
+
+int do_pip2_file_ioctl_seek_file_pointers_cmd(uint8_t seq_num,
+		uint8_t file_handle, uint32_t read_offset, uint32_t write_offset,
+		PIP2_Rsp_Payload_FileIOCTL_SeekFilePointers* rsp)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	if (rsp == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return EXIT_FAILURE;
+	} else if (seq_num > MAX_SEQ_NUM) {
+		output(ERROR,
+				"%s: The sequence number must be less <= 7 (%u was given).\n",
+				__func__, seq_num);
+		return EXIT_FAILURE;
+	}
+
+	uint16_t cmd_payload_len =
+			sizeof(PIP2_Cmd_Payload_FileIOCTL_SeekFilePointers) - 2;
+	PIP2_Cmd_Payload_FileIOCTL_SeekFilePointers cmd_data = {
+			.header = {
+					.cmd_reg_lsb        = PIP2_CMD_REG_LSB,
+					.cmd_reg_msb        = PIP2_CMD_REG_MSB,
+					.payload_len_lsb    = cmd_payload_len & 0xFF,
+					.payload_len_msb    = cmd_payload_len >> 8,
+					.seq                = seq_num,
+					.tag                = TAG_BIT,
+					.reserved_section_1 = 0,
+					.cmd_id             = (uint8_t) PIP2_CMD_ID_FILE_IOCTL,
+					.resp               = 0
+			},
+			.file_handle  = file_handle,
+			.ioctl_code   = (uint8_t) PIP2_IOCTL_CODE_SEEK_FILE_POINTERS,
+			.read_offset  = {
+					read_offset & 0xFF, (read_offset >> 8) & 0xFF,
+					(read_offset >> 16) & 0xFF, read_offset >> 24
+			},
+			.write_offset = {
+					write_offset & 0xFF, (write_offset >> 8) & 0xFF,
+					(write_offset >> 16) & 0xFF, write_offset >> 24
+			}
+	};
+	ReportData cmd = {
+			.data = (uint8_t*) &cmd_data,
+			.len  = sizeof(cmd_data)
+	};
+	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[2]),
+			cmd.len - 4);
+	cmd.data[cmd.len - 2] = cmd_crc >> 8;
+	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
+
+	ReportData _rsp = {
+			.data        = (uint8_t*) rsp,
+			.len         = 0,
+			.index       = 0,
+			.num_records = 0,
+			.max_len     = sizeof(PIP2_Rsp_Payload_FileIOCTL_SeekFilePointers)
+	};
+
+	return do_pip2_command(&cmd, &_rsp);
+}
+
 int do_pip2_file_open_cmd(uint8_t seq_num, uint8_t file_num,
 		PIP2_Rsp_Payload_FileOpen* rsp)
 {
@@ -369,7 +591,7 @@ int do_pip2_file_read_cmd(uint8_t seq_num, uint8_t file_handle,
 	uint8_t rsp_crc_msb;
 	uint8_t rsp_crc_lsb;
 
-	_rsp.data = calloc(_rsp.max_len, 1);
+	_rsp.data = get_pip_arena_buffer(&arena, _rsp.max_len, true);
 	if (_rsp.data == NULL) {
 		output(ERROR, "%s: Memory allocation failed.\n", __func__);
 		return EXIT_FAILURE;
@@ -383,6 +605,15 @@ int do_pip2_file_read_cmd(uint8_t seq_num, uint8_t file_handle,
 		rc = EXIT_FAILURE;
 		goto RETURN;
 	}
+	if (_rsp.len < sizeof(PIP2_Rsp_Header) + read_len
+			+ sizeof(PIP2_Rsp_Footer)) {
+		output(ERROR,
+				"%s: PIP2 FILE_READ response is too short for the %u bytes "
+				"that were asked for (%lu bytes).\n",
+				__func__, read_len, _rsp.len);
+		rc = EXIT_FAILURE;
+		goto RETURN;
+	}
 
 	memcpy((void*) &rsp->header, (void*) _rsp.data, sizeof(PIP2_Rsp_Header));
 
@@ -408,7 +639,7 @@ int do_pip2_file_read_cmd(uint8_t seq_num, uint8_t file_handle,
 	}
 
 RETURN:
-	free(_rsp.data);
+	put_pip_arena_buffer(&arena, _rsp.data);
 	return rc;
 }
 
@@ -430,13 +661,20 @@ int do_pip2_file_write_cmd(uint8_t seq_num, uint8_t file_handle, ByteData* data)
 	size_t data_part_start_index = 0;
 	bool error_occurred = false;
 	size_t max_data_per_cmd_len;
+	PIP_Encoder encoder;
+	PIP2_File_Write_Context encoder_ctx = {
+			.seq_num     = seq_num,
+			.file_handle = file_handle
+	};
+	uint part_index = 0;
+	uint num_in_place = 0;
 	int rc = EXIT_FAILURE;
 	size_t remaining_data_len = data->len;
 	size_t remaining_num_of_writes;
 
 	cmd.max_len = PIP2_FILE_WRITE_CMD_MAX_LEN;
 	max_data_per_cmd_len = cmd.max_len - PIP2_FILE_WRITE_CMD_WITHOUT_DATA_LEN;
-	cmd.data = malloc(cmd.max_len);
+	cmd.data = get_pip_arena_buffer(&arena, cmd.max_len, false);
 	if (cmd.data == NULL) {
 		output(ERROR, "%s: Memory allocation failed.\n", __func__);
 		return EXIT_FAILURE;
@@ -444,10 +682,16 @@ int do_pip2_file_write_cmd(uint8_t seq_num, uint8_t file_handle, ByteData* data)
 
 	remaining_num_of_writes =
 			(data->len + (max_data_per_cmd_len - 1)) / max_data_per_cmd_len;
+	start_pip_encoder(&encoder, data, max_data_per_cmd_len,
+			_calculate_pip2_file_write_crc, &encoder_ctx);
 
 	while (remaining_data_len > 0 && !error_occurred) {
 		uint16_t cmd_crc;
+		bool crc_ready;
 		size_t data_part_len;
+		PIP_Overlay overlay;
+		ReportData overlay_cmd = { .max_len = cmd.max_len };
+		ReportData* part_cmd = &cmd;
 		PIP2_Rsp_Payload_FileWrite rsp;
 		ReportData _rsp = {
 				.data        = (uint8_t*) &rsp,
@@ -460,12 +704,20 @@ int do_pip2_file_write_cmd(uint8_t seq_num, uint8_t file_handle, ByteData* data)
 		data_part_len = ((remaining_data_len > max_data_per_cmd_len)
 				? max_data_per_cmd_len : remaining_data_len);
 
-		cmd.len = data_part_len + PIP2_FILE_WRITE_CMD_WITHOUT_DATA_LEN;
-		if (cmd.len > cmd.max_len) {
+		crc_ready = get_pip_encoder_crc(&encoder, part_index++, &cmd_crc);
+		if (open_pip_overlay(&overlay, data, data_part_start_index,
+				data_part_len, FILE_WRITE_DATA_INDEX, sizeof(PIP2_Cmd_Footer),
+				&overlay_cmd)) {
+			part_cmd = &overlay_cmd;
+			num_in_place++;
+		}
+
+		part_cmd->len = data_part_len + PIP2_FILE_WRITE_CMD_WITHOUT_DATA_LEN;
+		if (part_cmd->len > part_cmd->max_len) {
 			output(ERROR,
 					"%s: PIP2 Command length (%u bytes) is too large per the "
 					"ROM Bootloader spec (%u bytes).\n",
-					__func__, cmd.len, cmd.max_len);
+					__func__, part_cmd->len, part_cmd->max_len);
 			rc = EXIT_FAILURE;
 			error_occurred = true;
 		}
@@ -473,29 +725,26 @@ int do_pip2_file_write_cmd(uint8_t seq_num, uint8_t file_handle, ByteData* data)
 		if (!error_occurred) {
 			remaining_data_len -= data_part_len;
 
-			PIP2_Cmd_Payload_FileWrite* cmd_data =
-					(PIP2_Cmd_Payload_FileWrite*) cmd.data;
-			uint16_t cmd_payload_len = (uint16_t) cmd.len - 2;
-
-			cmd_data->header.cmd_reg_lsb = PIP2_CMD_REG_LSB;
-			cmd_data->header.cmd_reg_msb = PIP2_CMD_REG_MSB;
-			cmd_data->header.payload_len_lsb = cmd_payload_len & 0xFF;
-			cmd_data->header.payload_len_msb = cmd_payload_len >> 8;
-			cmd_data->header.seq = seq_num;
-			cmd_data->header.tag = TAG_BIT;
-			cmd_data->header.reserved_section_1 = 0;
-			cmd_data->header.cmd_id = (uint8_t) PIP2_CMD_ID_FILE_WRITE;
-			cmd_data->header.resp = 0;
-			cmd_data->file_handle = file_handle;
-
-			memcpy((void*) &cmd.data[7],
-					(void*) &data->data[data_part_start_index], data_part_len);
-			cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[2]),
-					cmd.len - 4);
-			cmd.data[cmd.len - 2] = cmd_crc >> 8;
-			cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
-
-			rc = do_pip2_command(&cmd, &_rsp);
+			_fill_pip2_file_write_header(part_cmd->data, part_cmd->len,
+					seq_num, file_handle);
+
+			if (part_cmd == &cmd) {
+				memcpy((void*) &cmd.data[FILE_WRITE_DATA_INDEX],
+						(void*) &data->data[data_part_start_index],
+						data_part_len);
+			}
+			if (!crc_ready) {
+				cmd_crc = calculate_crc16_ccitt(0xFFFF, &(part_cmd->data[2]),
+						part_cmd->len - 4);
+			}
+			part_cmd->data[part_cmd->len - 2] = cmd_crc >> 8;
+			part_cmd->data[part_cmd->len - 1] = cmd_crc & 0xFF;
+
+			rc = do_pip2_command(part_cmd, &_rsp);
+		}
+		close_pip_overlay(&overlay);
+
+		if (!error_occurred) {
 			if (EXIT_SUCCESS != rc) {
 				output(ERROR,
 						"%s: Aborting the remaining %u FILE_WRITE commands that"
@@ -508,11 +757,19 @@ int do_pip2_file_write_cmd(uint8_t seq_num, uint8_t file_handle, ByteData* data)
 				output(DEBUG,
 					"Remaining number of FILE_WRITE commands to execute: %u.\n",
 					remaining_num_of_writes);
+				if (file_write_progress != NULL) {
+					file_write_progress(data_part_start_index,
+							file_write_progress_context);
+				}
 			}
 		}
 	}
 
-	free(cmd.data);
+	stop_pip_encoder(&encoder);
+	output(DEBUG,
+			"%u FILE_WRITE commands were sent in place from the image.\n",
+			num_in_place);
+	put_pip_arena_buffer(&arena, cmd.data);
 	return rc;
 }
 
@@ -610,6 +867,17 @@ bool is_pip2_api_active()
 	return active_channel_type != CHANNEL_TYPE_NONE;
 }
 
+void set_pip2_file_write_progress(PIP_Write_Progress_Func func, void* context)
+{
+	file_write_progress = func;
+	file_write_progress_context = context;
+}
+
+void set_pip2_fixed_cmd_delay(bool enable)
+{
+	use_fixed_cmd_delay = enable;
+}
+
 int setup_pip2_api(ChannelType channel_type, int i2c_bus_arg, int i2c_addr_arg)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
@@ -638,6 +906,11 @@ int setup_pip2_api(ChannelType channel_type, int i2c_bus_arg, int i2c_addr_arg)
 		return EXIT_FAILURE;
 	}
 
+	if (EXIT_SUCCESS != init_pip_arena(&arena, PIP_PROTOCOL_PIP2,
+			ARENA_SIZE)) {
+		return EXIT_FAILURE;
+	}
+
 	active_channel_type = channel_type;
 	output(DEBUG, "Using the %s channel type.\n",
 				CHANNEL_TYPE_NAMES[channel_type]);
@@ -654,6 +927,7 @@ int teardown_pip2_api()
 		output(DEBUG, "API is already inactive.\n");
 		break;
 	case CHANNEL_TYPE_I2CDEV:
+		release_pip_arena(&arena);
 		active_channel_type = CHANNEL_TYPE_NONE;
 		break;
 	default:
@@ -665,6 +939,38 @@ int teardown_pip2_api()
 	return EXIT_SUCCESS;
 }
 
+static uint16_t _calculate_pip2_file_write_crc(uint index,
+		const uint8_t* data, size_t len, void* context)
+{
+	PIP2_File_Write_Context* ctx = (PIP2_File_Write_Context*) context;
+	uint8_t header[FILE_WRITE_DATA_INDEX];
+	uint16_t crc;
+
+	_fill_pip2_file_write_header(header,
+			len + PIP2_FILE_WRITE_CMD_WITHOUT_DATA_LEN, ctx->seq_num,
+			ctx->file_handle);
+	crc = calculate_crc16_ccitt(0xFFFF, &header[2], sizeof(header) - 2);
+	return calculate_crc16_ccitt(crc, (uint8_t*) data, len);
+}
+
+static void _fill_pip2_file_write_header(uint8_t* cmd_data, size_t cmd_len,
+		uint8_t seq_num, uint8_t file_handle)
+{
+	PIP2_Cmd_Header* header = (PIP2_Cmd_Header*) cmd_data;
+	uint16_t cmd_payload_len = (uint16_t) cmd_len - 2;
+
+	header->cmd_reg_lsb = PIP2_CMD_REG_LSB;
+	header->cmd_reg_msb = PIP2_CMD_REG_MSB;
+	header->payload_len_lsb = cmd_payload_len & 0xFF;
+	header->payload_len_msb = cmd_payload_len >> 8;
+	header->seq = seq_num;
+	header->tag = TAG_BIT;
+	header->reserved_section_1 = 0;
+	header->cmd_id = (uint8_t) PIP2_CMD_ID_FILE_WRITE;
+	header->resp = 0;
+	cmd_data[sizeof(PIP2_Cmd_Header)] = file_handle;
+}
+
 static int _send_report_via_i2cdev(const ReportData* report)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
@@ -711,8 +1017,44 @@ static Poll_Status _get_report_from_i2cdev(ReportData* report,
 	output(DEBUG, "%s: Starting.\n", __func__);
 	Poll_Status rc = POLL_STATUS_ERROR;
 	uint8_t rsp_len_bytes[2] = {0};
+	struct timespec deadline;
+	struct timespec now;
+	uint poll_interval_us = RSP_POLL_MIN_INTERVAL_US;
+	ssize_t num_bytes_read;
+
+	/*
+	 * Until the response is ready the device either NAKs the read or reports
+	 * an invalid length, so the length is polled with a growing interval
+	 * instead of waiting a fixed delay after every command.
+	 */
+	get_monotonic_deadline(&deadline, timeout_val);
+	while (true) {
+		errno = 0;
+		num_rsp_polls++;
+		num_bytes_read = read(i2c_dev_fd, rsp_len_bytes, 2);
+		report->len = (size_t) ((rsp_len_bytes[1] << 8) | rsp_len_bytes[0]);
+		if (use_fixed_cmd_delay || !apply_timeout
+				|| (errno == 0 && num_bytes_read == 2
+						&& report->len >= PIP2_RSP_MIN_LEN
+						&& report->len != 0xFFFF)) {
+			break;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec
+				&& now.tv_nsec >= deadline.tv_nsec)) {
+			output(DEBUG, "%s: No response within %.3Lf seconds.\n",
+					__func__, timeout_val);
+			rc = POLL_STATUS_TIMEOUT;
+			goto RETURN;
+		}
+
+		sleep_us(poll_interval_us);
+		if (poll_interval_us < RSP_POLL_MAX_INTERVAL_US) {
+			poll_interval_us *= 2;
+		}
+	}
 
-	ssize_t num_bytes_read = read(i2c_dev_fd, rsp_len_bytes, 2);
 	if (errno != 0) {
 		output(ERROR, "%s: Failed to read the report length. %s [%d].\n",
 				__func__, strerror(errno), errno);
@@ -726,9 +1068,10 @@ static Poll_Status _get_report_from_i2cdev(ReportData* report,
 		rc = POLL_STATUS_ERROR;
 		goto RETURN;
 	}
-	report->len = (size_t) ((rsp_len_bytes[1] << 8) | rsp_len_bytes[0]);
 
-	sleep_ms(AVG_DELAY_BETWEEN_CMD_AND_RSP);
+	if (use_fixed_cmd_delay) {
+		sleep_ms(AVG_DELAY_BETWEEN_CMD_AND_RSP);
+	}
 
 	num_bytes_read = read(i2c_dev_fd, report->data, report->len);
 	if (errno != 0) {
@@ -742,6 +1085,7 @@ static Poll_Status _get_report_from_i2cdev(ReportData* report,
 				__func__, num_bytes_read, report->len);
 		rc = POLL_STATUS_ERROR;
 	} else {
+		clock_gettime(CLOCK_MONOTONIC, &report->timestamp);
 		rc = POLL_STATUS_GOT_DATA;
 	}
 
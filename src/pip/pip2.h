@@ -14,6 +14,10 @@
 #include "../sleep/ptlib_sleep.h"
 #include "pip2_cmd_id.h"
 #include "pip2_status_code.h"
+#include "pip_arena.h"
+#include "pip_encoder.h"
+#include "pip_overlay.h"
+#include "pip_stats.h"
 
 typedef enum {
 	PIP2_EXEC_ROM = 0x00,
@@ -118,6 +122,52 @@ typedef struct {
 	PIP2_Rsp_Footer footer;
 } __attribute__((packed)) PIP2_Rsp_Payload_FileIOCTL_EraseFile;
 
+typedef struct {
+	PIP2_Cmd_Header header;
+	uint8_t file_handle;
+	uint8_t ioctl_code;
+	uint8_t offset[4];
+	uint8_t len[4];
+	PIP2_Cmd_Footer footer;
+} __attribute__((packed)) PIP2_Cmd_Payload_FileIOCTL_FileCRC;
+
+typedef struct {
+	PIP2_Rsp_Header header;
+	uint8_t crc_lsb;
+	uint8_t crc_msb;
+	PIP2_Rsp_Footer footer;
+} __attribute__((packed)) PIP2_Rsp_Payload_FileIOCTL_FileCRC;
+
+typedef struct {
+	PIP2_Cmd_Header header;
+	uint8_t file_handle;
+	uint8_t ioctl_code;
+	PIP2_Cmd_Footer footer;
+} __attribute__((packed)) PIP2_Cmd_Payload_FileIOCTL_FileStats;
+
+typedef struct {
+	PIP2_Rsp_Header header;
+	uint8_t address[4];
+	uint8_t file_size[4];
+	PIP2_Rsp_Footer footer;
+} __attribute__((packed)) PIP2_Rsp_Payload_FileIOCTL_FileStats;
+
+typedef struct {
+	PIP2_Cmd_Header header;
+	uint8_t file_handle;
+	uint8_t ioctl_code;
+	uint8_t read_offset[4];
+	uint8_t write_offset[4];
+	PIP2_Cmd_Footer footer;
+} __attribute__((packed)) PIP2_Cmd_Payload_FileIOCTL_SeekFilePointers;
+
+typedef struct {
+	PIP2_Rsp_Header header;
+	uint8_t read_offset[4];
+	uint8_t write_offset[4];
+	PIP2_Rsp_Footer footer;
+} __attribute__((packed)) PIP2_Rsp_Payload_FileIOCTL_SeekFilePointers;
+
 typedef struct {
 	PIP2_Cmd_Header header;
 	uint8_t file_num;
@@ -144,6 +194,12 @@ typedef struct {
 	PIP2_Rsp_Footer footer;
 } __attribute__((packed)) PIP2_Rsp_Payload_FileRead;
 
+/*
+ * The ROM-BL takes I2C transfers of up to 255 bytes, so FILE_READ responses
+ * are kept within the same size as FILE_WRITE commands.
+ */
+#define PIP2_FILE_READ_MAX_LEN (PIP2_FILE_WRITE_CMD_MAX_LEN - PIP2_RSP_MIN_LEN)
+
 typedef struct {
 	PIP2_Cmd_Header header;
 	uint8_t file_handle;
@@ -194,8 +250,15 @@ extern Poll_Status (*get_pip2_rsp_via_channel)(ReportData* report, bool apply_ti
 extern int do_pip2_command(ReportData* cmd, ReportData* rsp);
 extern int do_pip2_file_close_cmd(uint8_t seq_num, uint8_t file_handle,
 		PIP2_Rsp_Payload_FileClose* rsp);
+extern int do_pip2_file_ioctl_crc_cmd(uint8_t seq_num, uint8_t file_handle,
+		uint32_t offset, uint32_t len, PIP2_Rsp_Payload_FileIOCTL_FileCRC* rsp);
 extern int do_pip2_file_ioctl_erase_file_cmd(uint8_t seq_num,
 		uint8_t file_handle, PIP2_Rsp_Payload_FileIOCTL_EraseFile* rsp);
+extern int do_pip2_file_ioctl_file_stats_cmd(uint8_t seq_num,
+		uint8_t file_handle, PIP2_Rsp_Payload_FileIOCTL_FileStats* rsp);
+extern int do_pip2_file_ioctl_seek_file_pointers_cmd(uint8_t seq_num,
+		uint8_t file_handle, uint32_t read_offset, uint32_t write_offset,
+		PIP2_Rsp_Payload_FileIOCTL_SeekFilePointers* rsp);
 extern int do_pip2_file_open_cmd(uint8_t seq_num, uint8_t file_num,
 		PIP2_Rsp_Payload_FileOpen* rsp);
 extern int do_pip2_file_read_cmd(uint8_t seq_num, uint8_t file_handle,
@@ -205,6 +268,9 @@ extern int do_pip2_file_write_cmd(uint8_t seq_num, uint8_t file_handle,
 extern int do_pip2_reset_cmd(uint8_t seq_num);
 extern int do_pip2_status_cmd(uint8_t seq_num, PIP2_Rsp_Payload_Status* rsp);
 extern bool is_pip2_api_active();
+extern void set_pip2_file_write_progress(PIP_Write_Progress_Func func,
+		void* context);
+extern void set_pip2_fixed_cmd_delay(bool enable);
 extern int setup_pip2_api(ChannelType channel_type, int i2c_bus_arg,
 		int i2c_addr_arg);
 extern int teardown_pip2_api();
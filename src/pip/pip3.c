@@ -7,11 +7,24 @@
 #define AVG_DELAY_BETWEEN_CMD_AND_RSP 5 
 
 #define MAX_TIMEOUT_BETWEEN_CMD_AND_RSP 7 
+#define FLASH_TIMEOUT_BETWEEN_CMD_AND_RSP 15
 
 #define MAX_SEQ_NUM 0x07
 
 #define TAG_BIT 1
 
+#define DISCARD_RSP_TIMEOUT 0.1
+
+/*
+ * PIP3 response payload lengths are 16-bit, so this covers any single
+ * response buffer.
+ */
+#define ARENA_RSP_LEN 0xFFFF
+
+#define TABLE_CMD_MAX_LEN 24
+
+#define FILE_WRITE_DATA_INDEX (sizeof(PIP3_Cmd_Header) + sizeof(uint8_t))
+
 char* PIP3_EXEC_NAMES[] = {
 		[PIP3_EXEC_ROM] = "ROM Bootloader EXEC",
 		[PIP3_EXEC_RAM] = "RAM Application EXEC"
@@ -58,179 +71,286 @@ static bool        async_debug_data_mode_activated = false;
 static PIP3_Cmd_ID async_debug_data_mode_cmd_id;
 static uint8_t     async_debug_data_mode_seq;
 
-static int _verify_pip3_rsp_report(HID_Report_ID report_id, uint8_t seq,
-		PIP3_Cmd_ID cmd_id, const HID_Input_PIP3_Response* rsp);
-int (*send_report_via_channel)(const ReportData* report);
-Poll_Status (*get_report_via_channel)(ReportData* report, bool apply_timeout,
-		long double timeout_val);
-
-int do_pip3_command(ReportData* cmd, ReportData* rsp)
-{
-	const HID_Output_PIP3_Command* output_report;
-	bool more_reports = false;
-	size_t payload_len = 0;
-	size_t remaining_payload_len = 0;
-	int rc;
-	Poll_Status read_rc;
-	ReportData rsp_report;
-
-	output_report = (HID_Output_PIP3_Command*) cmd->data;
-
-	rsp_report.data = NULL;
-	rsp_report.max_len = hid_max_input_report_len - 2;
-	rsp_report.data = (uint8_t*) malloc(rsp_report.max_len * sizeof(uint8_t));
-	if (rsp_report.data == NULL) {
-		output(ERROR, "%s: Memory allocation failed. %s [%d].\n", __func__,
-				strerror(errno), errno);
-		return EXIT_FAILURE;
-	}
-
-	output_debug_report(REPORT_DIRECTION_OUTGOING_TO_DUT, REPORT_FORMAT_HID,
-			PIP3_CMD_NAMES[output_report->cmd_id], REPORT_TYPE_COMMAND, cmd);
-	rc = send_report_via_channel(cmd);
-	if (rc != EXIT_SUCCESS) {
-		goto RETURN;
-	}
-
-	sleep_ms(AVG_DELAY_BETWEEN_CMD_AND_RSP);
+static uint        num_timed_cmds;
+static long double device_turnaround_ms;
+static long double device_turnaround_min_ms;
+static long double device_turnaround_max_ms;
+static long double cmd_time_ms;
 
-	do {
-		const HID_Input_PIP3_Response* input_report;
+static PIP_Arena arena = { .base = NULL, .protocol = PIP_PROTOCOL_PIP3 };
+static bool use_fixed_cmd_delay = false;
 
-		memset(rsp_report.data, 0, sizeof(rsp_report.max_len));
-		read_rc = get_report_via_channel(&rsp_report, true,
-				MAX_TIMEOUT_BETWEEN_CMD_AND_RSP);
-		switch (read_rc) {
-		case POLL_STATUS_GOT_DATA:
-			break;
-		case POLL_STATUS_TIMEOUT:
-			output(ERROR,
-					"%s: Timed-Out waiting for PIP3 %s Response.\n",
-					__func__, PIP3_CMD_NAMES[output_report->cmd_id]);
-			rc = EXIT_FAILURE;
-			break;
-		case POLL_STATUS_ERROR:
-			output(ERROR,
-					"%s: Unexpected error occurred while attempting to retrieve"
-					" the PIP3 %s Response.\n",
-					__func__, PIP3_CMD_NAMES[output_report->cmd_id]);
-			rc = EXIT_FAILURE;
-			break;
-		default:
-			output(ERROR,
-					"%s: Unexpected 'Poll_Status' enum value (%d) for pending "
-					"PIP3 %s Response.\n",
-					__func__, read_rc, PIP3_CMD_NAMES[output_report->cmd_id]);
-			rc = EXIT_FAILURE;
-		}
+/*
+ * The FILE_WRITE window grows by one command after each fully acknowledged
+ * window and is halved when a windowed write fails, so it settles at what the
+ * device tolerates. It is kept across writes.
+ */
+static uint file_write_max_window = 1;
+static uint file_write_window = 1;
+static PIP_Write_Progress_Func file_write_progress = NULL;
+static void* file_write_progress_context = NULL;
+
+typedef enum {
+	PIP3_TIMEOUT_CLASS_DEFAULT,
+	PIP3_TIMEOUT_CLASS_FLASH,
+	NUM_PIP3_TIMEOUT_CLASSES
+} PIP3_Timeout_Class;
+
+static const long double PIP3_TIMEOUTS[] = {
+		[PIP3_TIMEOUT_CLASS_DEFAULT] = MAX_TIMEOUT_BETWEEN_CMD_AND_RSP,
+		[PIP3_TIMEOUT_CLASS_FLASH]   = FLASH_TIMEOUT_BETWEEN_CMD_AND_RSP
+};
 
-		if (rc == EXIT_SUCCESS) {
-			input_report = (HID_Input_PIP3_Response*) rsp_report.data;
-			rc = _verify_pip3_rsp_report(HID_REPORT_ID_SOLICITED_RESPONSE,
-					output_report->seq, output_report->cmd_id, input_report);
-		}
+typedef enum {
+	PIP3_CMD_DESC_CALIBRATE,
+	PIP3_CMD_DESC_FILE_CLOSE,
+	PIP3_CMD_DESC_FILE_IOCTL_CRC,
+	PIP3_CMD_DESC_FILE_IOCTL_ERASE_FILE,
+	PIP3_CMD_DESC_FILE_IOCTL_FILE_STATS,
+	PIP3_CMD_DESC_FILE_IOCTL_SEEK_FILE_POINTERS,
+	PIP3_CMD_DESC_FILE_OPEN,
+	PIP3_CMD_DESC_FILE_READ,
+	PIP3_CMD_DESC_GET_SELF_TEST_RESULTS,
+	PIP3_CMD_DESC_GET_SYSINFO,
+	PIP3_CMD_DESC_INITIALIZE_BASELINES,
+	PIP3_CMD_DESC_RESUME_SCANNING,
+	PIP3_CMD_DESC_RUN_SELF_TEST,
+	PIP3_CMD_DESC_START_TRACKING_HEATMAP,
+	PIP3_CMD_DESC_STATUS,
+	PIP3_CMD_DESC_STOP_ASYNC_DEBUG_DATA,
+	PIP3_CMD_DESC_SUSPEND_SCANNING,
+	PIP3_CMD_DESC_SWITCH_ACTIVE_PROCESSOR,
+	PIP3_CMD_DESC_SWITCH_IMAGE,
+	PIP3_CMD_DESC_VERSION,
+	NUM_PIP3_CMD_DESCS
+} PIP3_Cmd_Desc_ID;
 
-		if (rc != EXIT_SUCCESS) {
-			goto RETURN;
-		}
+/*
+ * Fixed-layout PIP3 commands. The command length covers the whole output
+ * report, so the parameters are the bytes between the header and the CRC. A
+ * response length of 0 means the caller provides the response buffer size.
+ * Commands without parameters carry their CRC for each SEQ number.
+ */
+typedef struct {
+	PIP3_Cmd_ID cmd_id;
+	uint8_t cmd_len;
+	uint16_t rsp_len;
+	PIP3_Timeout_Class timeout_class;
+	const uint16_t* crcs;
+} PIP3_Cmd_Desc;
+
+static const uint16_t GET_SYSINFO_CRCS[MAX_SEQ_NUM + 1] = {
+		0x3CE1, 0x0FD0, 0x5A83, 0x69B2, 0xF025, 0xC314, 0x9647, 0xA576
+};
+static const uint16_t RESUME_SCANNING_CRCS[MAX_SEQ_NUM + 1] = {
+		0x5C27, 0x6F16, 0x3A45, 0x0974, 0x90E3, 0xA3D2, 0xF681, 0xC5B0
+};
+static const uint16_t START_TRACKING_HEATMAP_CRCS[MAX_SEQ_NUM + 1] = {
+		0xEF5C, 0xDC6D, 0x893E, 0xBA0F, 0x2398, 0x10A9, 0x45FA, 0x76CB
+};
+static const uint16_t STATUS_CRCS[MAX_SEQ_NUM + 1] = {
+		0x3AD1, 0x09E0, 0x5CB3, 0x6F82, 0xF615, 0xC524, 0x9077, 0xA346
+};
+static const uint16_t STOP_ASYNC_DEBUG_DATA_CRCS[MAX_SEQ_NUM + 1] = {
+		0xDF3F, 0xEC0E, 0xB95D, 0x8A6C, 0x13FB, 0x20CA, 0x7599, 0x46A8
+};
+static const uint16_t SUSPEND_SCANNING_CRCS[MAX_SEQ_NUM + 1] = {
+		0x2CC0, 0x1FF1, 0x4AA2, 0x7993, 0xE004, 0xD335, 0x8666, 0xB557
+};
+static const uint16_t VERSION_CRCS[MAX_SEQ_NUM + 1] = {
+		0x5A17, 0x6926, 0x3C75, 0x0F44, 0x96D3, 0xA5E2, 0xF0B1, 0xC380
+};
 
-		more_reports = input_report->more_reports;
-		if (input_report->first_report == 1) {
-			payload_len = ((input_report->payload_len_msb << 8)
-					| input_report->payload_len_lsb);
-			remaining_payload_len = payload_len;
-			output(DEBUG, "Payload Length: %u\n", payload_len);
-			output_debug_report(REPORT_DIRECTION_INCOMING_FROM_DUT,
-					REPORT_FORMAT_HID, PIP3_CMD_NAMES[output_report->cmd_id],
-					REPORT_TYPE_RESPONSE, &rsp_report);
-		} else {
-			output_debug_report(REPORT_DIRECTION_INCOMING_FROM_DUT,
-					REPORT_FORMAT_HID, "(continued response)",
-					REPORT_TYPE_RESPONSE, &rsp_report);
+static const PIP3_Cmd_Desc PIP3_CMD_DESCS[] = {
+		[PIP3_CMD_DESC_CALIBRATE] = {
+				.cmd_id        = PIP3_CMD_ID_CALIBRATE,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_Calibrate),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_Calibrate),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT
+		},
+		[PIP3_CMD_DESC_FILE_CLOSE] = {
+				.cmd_id        = PIP3_CMD_ID_FILE_CLOSE,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_FileClose),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_FileClose),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT
+		},
+		[PIP3_CMD_DESC_FILE_IOCTL_CRC] = {
+				.cmd_id        = PIP3_CMD_ID_FILE_IOCTL,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_FileIOCTL_FileCRC),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_FileIOCTL_FileCRC),
+				.timeout_class = PIP3_TIMEOUT_CLASS_FLASH
+		},
+		[PIP3_CMD_DESC_FILE_IOCTL_ERASE_FILE] = {
+				.cmd_id        = PIP3_CMD_ID_FILE_IOCTL,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_FileIOCTL_EraseFile),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_FileIOCTL_EraseFile),
+				.timeout_class = PIP3_TIMEOUT_CLASS_FLASH
+		},
+		[PIP3_CMD_DESC_FILE_IOCTL_FILE_STATS] = {
+				.cmd_id        = PIP3_CMD_ID_FILE_IOCTL,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_FileIOCTL_FileStats),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_FileIOCTL_FileStats),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT
+		},
+		[PIP3_CMD_DESC_FILE_IOCTL_SEEK_FILE_POINTERS] = {
+				.cmd_id        = PIP3_CMD_ID_FILE_IOCTL,
+				.cmd_len       =
+						sizeof(PIP3_Cmd_Payload_FileIOCTL_SeekFilePointers),
+				.rsp_len       =
+						sizeof(PIP3_Rsp_Payload_FileIOCTL_SeekFilePointers),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT
+		},
+		[PIP3_CMD_DESC_FILE_OPEN] = {
+				.cmd_id        = PIP3_CMD_ID_FILE_OPEN,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_FileOpen),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_FileOpen),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT
+		},
+		[PIP3_CMD_DESC_FILE_READ] = {
+				.cmd_id        = PIP3_CMD_ID_FILE_READ,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_FileRead),
+				.rsp_len       = 0,
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT
+		},
+		[PIP3_CMD_DESC_GET_SELF_TEST_RESULTS] = {
+				.cmd_id        = PIP3_CMD_ID_GET_SELF_TEST_RESULTS,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_GetSelfTestResults),
+				.rsp_len       = 0,
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT
+		},
+		[PIP3_CMD_DESC_GET_SYSINFO] = {
+				.cmd_id        = PIP3_CMD_ID_GET_SYSINFO,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_GetSysinfo),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_GetSysinfo),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT,
+				.crcs          = GET_SYSINFO_CRCS
+		},
+		[PIP3_CMD_DESC_INITIALIZE_BASELINES] = {
+				.cmd_id        = PIP3_CMD_ID_INITIALIZE_BASELINE,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_InitializeBaselines),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_InitializeBaselines),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT
+		},
+		[PIP3_CMD_DESC_RESUME_SCANNING] = {
+				.cmd_id        = PIP3_CMD_ID_RESUME_SCAN,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_ResumeScanning),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_ResumeScanning),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT,
+				.crcs          = RESUME_SCANNING_CRCS
+		},
+		[PIP3_CMD_DESC_RUN_SELF_TEST] = {
+				.cmd_id        = PIP3_CMD_ID_RUN_SELF_TEST,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_RunSelfTest),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_RunSelfTest),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT
+		},
+		[PIP3_CMD_DESC_START_TRACKING_HEATMAP] = {
+				.cmd_id        = PIP3_CMD_ID_START_TRACKING_HEATMAP,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_StartTrackingHeatmap),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_StartTrackingHeatmap),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT,
+				.crcs          = START_TRACKING_HEATMAP_CRCS
+		},
+		[PIP3_CMD_DESC_STATUS] = {
+				.cmd_id        = PIP3_CMD_ID_STATUS,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_Status),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_Status),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT,
+				.crcs          = STATUS_CRCS
+		},
+		[PIP3_CMD_DESC_STOP_ASYNC_DEBUG_DATA] = {
+				.cmd_id        = PIP3_CMD_ID_STOP_ASYNC_DEBUG_DATA,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_StopAsyncDebugData),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_StopAsyncDebugData),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT,
+				.crcs          = STOP_ASYNC_DEBUG_DATA_CRCS
+		},
+		[PIP3_CMD_DESC_SUSPEND_SCANNING] = {
+				.cmd_id        = PIP3_CMD_ID_SUSPEND_SCAN,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_SuspendScanning),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_SuspendScanning),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT,
+				.crcs          = SUSPEND_SCANNING_CRCS
+		},
+		[PIP3_CMD_DESC_SWITCH_ACTIVE_PROCESSOR] = {
+				.cmd_id        = PIP3_CMD_ID_SWITCH_ACTIVE_PROCESSOR,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_SwitchActiveProcessor),
+				.rsp_len       = 0,
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT
+		},
+		[PIP3_CMD_DESC_SWITCH_IMAGE] = {
+				.cmd_id        = PIP3_CMD_ID_SWITCH_IMAGE,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_SwitchImage),
+				.rsp_len       = 0,
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT
+		},
+		[PIP3_CMD_DESC_VERSION] = {
+				.cmd_id        = PIP3_CMD_ID_VERSION,
+				.cmd_len       = sizeof(PIP3_Cmd_Payload_Version),
+				.rsp_len       = sizeof(PIP3_Rsp_Payload_Version),
+				.timeout_class = PIP3_TIMEOUT_CLASS_DEFAULT,
+				.crcs          = VERSION_CRCS
 		}
+};
 
-		if (rsp != NULL) {
-			size_t rsp_report_len = rsp_report.len - 2;
-
-			size_t copy_len = ((remaining_payload_len > rsp_report_len)
-					? rsp_report_len : remaining_payload_len);
-
-			if (payload_len > rsp->max_len) {
-				output(ERROR, "%s: The response payload is larger (%u bytes) "
-						"than the maximum size supported (%u bytes).\n",
-						__func__, payload_len, rsp->max_len);
-				rc = EXIT_FAILURE;
-			} else if (copy_len + rsp->len > payload_len) {
-				output(ERROR, "%s: The response reports added up to a larger "
-						"total paylaod (%u) than expected (%u bytes).\n",
-						__func__, copy_len + rsp->len, payload_len);
-				rc = EXIT_FAILURE;
-			} else {
-				memcpy(&(rsp->data[rsp->len]),
-						&(rsp_report.data[
-								HID_INPUT_PIP3_RSP_PAYLOAD_START_BYTE_INDEX]),
-						copy_len);
-
-				rsp->len += copy_len;
-				remaining_payload_len -= copy_len;
-			}
-		}
-	} while (rc == EXIT_SUCCESS && more_reports);
+typedef struct {
+	bool received;
+	bool timed_out;
+	struct timespec first_report_time;
+	struct timespec last_report_time;
+} PIP3_Rsp_Timing;
+
+typedef struct {
+	uint8_t seq_num;
+	bool advance_seq;
+	uint8_t file_handle;
+} PIP3_File_Write_Context;
+
+static int _build_pip3_file_write_cmd(ReportData* cmd, uint8_t seq_num,
+		uint8_t file_handle, const uint8_t* data, size_t data_len,
+		const uint16_t* crc);
+static uint16_t _calculate_pip3_file_write_crc(uint index,
+		const uint8_t* data, size_t len, void* context);
+static void _discard_pip3_rsps();
+static int _do_pip3_command(ReportData* cmd, ReportData* rsp,
+		long double timeout);
+static int _do_pip3_table_cmd(PIP3_Cmd_Desc_ID desc_id, uint8_t seq_num,
+		const uint8_t* params, void* rsp);
+static int _do_pip3_windowed_file_write(uint8_t seq_num, uint8_t file_handle,
+		ByteData* data);
+static int _encode_pip3_table_cmd(PIP3_Cmd_Desc_ID desc_id, uint8_t seq_num,
+		const uint8_t* params, ReportData* cmd);
+static void _fill_pip3_file_write_header(uint8_t* cmd_data, size_t cmd_len,
+		uint8_t seq_num, uint8_t file_handle);
+static int _get_pip3_rsp(PIP3_Cmd_ID cmd_id, uint8_t seq, ReportData* rsp,
+		long double timeout, PIP3_Rsp_Timing* timing);
+static void _record_pip3_cmd_time(PIP3_Cmd_ID cmd_id,
+		const struct timespec* start_time, const struct timespec* send_time,
+		const PIP3_Rsp_Timing* timing, const struct timespec* end_time);
+static int _verify_pip3_rsp_report(HID_Report_ID report_id, uint8_t seq,
+		PIP3_Cmd_ID cmd_id, const HID_Input_PIP3_Response* rsp);
+int (*send_report_via_channel)(ReportData* report);
+int (*send_reports_via_channel)(ReportData* reports, uint num_reports);
+Poll_Status (*get_report_via_channel)(HID_Report_ID report_id,
+		ReportData* report, bool apply_timeout, long double timeout_val);
+Poll_Status (*borrow_report_via_channel)(HID_Report_ID report_id,
+		ReportData** report, bool apply_timeout, long double timeout_val);
+void (*release_report_via_channel)();
 
-RETURN:
-	free(rsp_report.data);
-	return rc;
+int do_pip3_command(ReportData* cmd, ReportData* rsp)
+{
+	return _do_pip3_command(cmd, rsp,
+			PIP3_TIMEOUTS[PIP3_TIMEOUT_CLASS_DEFAULT]);
 }
 
 int do_pip3_calibrate_cmd(uint8_t seq_num, uint8_t calibration_mode,
 		uint8_t data_0, uint8_t data_1, uint8_t data_2)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
+	PIP3_Rsp_Payload_Calibrate rsp;
 
-	if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
-	}
-
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_Calibrate) - 1;
-	PIP3_Cmd_Payload_Calibrate cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             = (uint8_t) PIP3_CMD_ID_CALIBRATE,
-					.resp               = 0
-			},
-			.calibration_mode = calibration_mode,
-			.data_0           = data_0,
-			.data_1           = data_1,
-			.data_2           = data_2,
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
-
-	PIP3_Rsp_Payload_Calibrate rsp_data;
-	ReportData rsp = {
-			.data        = (uint8_t*) &rsp_data,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_Calibrate)
-	};
-
-	return do_pip3_command(&cmd, &rsp);
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_CALIBRATE, seq_num,
+			(uint8_t[]) { calibration_mode, data_0, data_1, data_2 }, &rsp);
 }
 
 int do_pip3_initialize_baselines_cmd(uint8_t seq_num, uint8_t data_id_mask,
@@ -241,47 +361,10 @@ int do_pip3_initialize_baselines_cmd(uint8_t seq_num, uint8_t data_id_mask,
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_InitializeBaselines) - 1;
-	PIP3_Cmd_Payload_InitializeBaselines cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             =
-									(uint8_t) PIP3_CMD_ID_INITIALIZE_BASELINE,
-					.resp               = 0
-			},
-			.data_id_mask = data_id_mask,
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
-
-	ReportData _rsp = {
-			.data        = (uint8_t*) rsp,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_InitializeBaselines)
-	};
-
-	return do_pip3_command(&cmd, &_rsp);
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_INITIALIZE_BASELINES, seq_num,
+			(uint8_t[]) { data_id_mask }, rsp);
 }
 
 int do_pip3_file_close_cmd(uint8_t seq_num, uint8_t file_handle,
@@ -292,46 +375,30 @@ int do_pip3_file_close_cmd(uint8_t seq_num, uint8_t file_handle,
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_FileClose) - 1;
-	PIP3_Cmd_Payload_FileClose cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             = (uint8_t) PIP3_CMD_ID_FILE_CLOSE,
-					.resp               = 0
-			},
-			.file_handle = file_handle,
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_FILE_CLOSE, seq_num,
+			(uint8_t[]) { file_handle }, rsp);
+}
 
-	ReportData _rsp = {
-			.data        = (uint8_t*) rsp,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_FileClose)
-	};
+int do_pip3_file_ioctl_crc_cmd(uint8_t seq_num, uint8_t file_handle,
+		uint32_t offset, uint32_t len, PIP3_Rsp_Payload_FileIOCTL_FileCRC* rsp)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	if (rsp == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return EXIT_FAILURE;
+	}
 
-	return do_pip3_command(&cmd, &_rsp);
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_FILE_IOCTL_CRC, seq_num,
+			(uint8_t[]) {
+					file_handle, (uint8_t) PIP3_IOCTL_CODE_FILE_CRC,
+					offset & 0xFF, (offset >> 8) & 0xFF,
+					(offset >> 16) & 0xFF, offset >> 24,
+					len & 0xFF, (len >> 8) & 0xFF, (len >> 16) & 0xFF, len >> 24
+			},
+			rsp);
 }
 
 int do_pip3_file_ioctl_erase_file_cmd(uint8_t seq_num, uint8_t file_handle,
@@ -342,97 +409,63 @@ int do_pip3_file_ioctl_erase_file_cmd(uint8_t seq_num, uint8_t file_handle,
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_FileIOCTL_EraseFile) - 1;
-	PIP3_Cmd_Payload_FileIOCTL_EraseFile cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             = (uint8_t) PIP3_CMD_ID_FILE_IOCTL,
-					.resp               = 0
-			},
-			.file_handle = file_handle,
-			.ioctl_code  = (uint8_t) PIP3_IOCTL_CODE_ERASE_FILE
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_FILE_IOCTL_ERASE_FILE, seq_num,
+			(uint8_t[]) { file_handle, (uint8_t) PIP3_IOCTL_CODE_ERASE_FILE },
+			rsp);
+}
 
-	ReportData _rsp = {
-			.data        = (uint8_t*) rsp,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_FileIOCTL_EraseFile)
-	};
+int do_pip3_file_ioctl_file_stats_cmd(uint8_t seq_num, uint8_t file_handle,
+		PIP3_Rsp_Payload_FileIOCTL_FileStats* rsp)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	if (rsp == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return EXIT_FAILURE;
+	}
 
-	return do_pip3_command(&cmd, &_rsp);
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_FILE_IOCTL_FILE_STATS, seq_num,
+			(uint8_t[]) { file_handle, (uint8_t) PIP3_IOCTL_CODE_FILE_STATS },
+			rsp);
 }
 
-int do_pip3_file_open_cmd(uint8_t seq_num, uint8_t file_num,
-		PIP3_Rsp_Payload_FileOpen* rsp)
+int do_pip3_file_ioctl_seek_file_pointers_cmd(uint8_t seq_num,
+		uint8_t file_handle, uint32_t read_offset, uint32_t write_offset,
+		PIP3_Rsp_Payload_FileIOCTL_SeekFilePointers* rsp)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
 
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_FileOpen) - 1;
-	PIP3_Cmd_Payload_FileOpen cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             = (uint8_t) PIP3_CMD_ID_FILE_OPEN,
-					.resp               = 0
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_FILE_IOCTL_SEEK_FILE_POINTERS,
+			seq_num,
+			(uint8_t[]) {
+					file_handle, (uint8_t) PIP3_IOCTL_CODE_SEEK_FILE_POINTERS,
+					read_offset & 0xFF, (read_offset >> 8) & 0xFF,
+					(read_offset >> 16) & 0xFF, read_offset >> 24,
+					write_offset & 0xFF, (write_offset >> 8) & 0xFF,
+					(write_offset >> 16) & 0xFF, write_offset >> 24
 			},
-			.file_num = file_num,
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
+			rsp);
+}
 
-	ReportData _rsp = {
-			.data        = (uint8_t*) rsp,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_FileOpen)
-	};
+int do_pip3_file_open_cmd(uint8_t seq_num, uint8_t file_num,
+		PIP3_Rsp_Payload_FileOpen* rsp)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	if (rsp == NULL) {
+		output(ERROR, "%s: NULL argument provided.\n", __func__);
+		return EXIT_FAILURE;
+	}
 
-	return do_pip3_command(&cmd, &_rsp);
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_FILE_OPEN, seq_num,
+			(uint8_t[]) { file_num }, rsp);
 }
 
 int do_pip3_file_read_cmd(uint8_t seq_num, uint8_t file_handle,
@@ -444,38 +477,18 @@ int do_pip3_file_read_cmd(uint8_t seq_num, uint8_t file_handle,
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_FileRead) - 1;
-	PIP3_Cmd_Payload_FileRead cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             = (uint8_t) PIP3_CMD_ID_FILE_READ,
-					.resp               = 0
-			},
-			.file_handle  = file_handle,
-			.read_len_lsb = read_len & 0xFF,
-			.read_len_msb = read_len >> 8
-	};
+	uint8_t cmd_data[TABLE_CMD_MAX_LEN];
 	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
+			.data    = cmd_data,
+			.max_len = sizeof(cmd_data)
 	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
+	if (EXIT_SUCCESS != _encode_pip3_table_cmd(
+			PIP3_CMD_DESC_FILE_READ, seq_num,
+			(uint8_t[]) { file_handle, read_len & 0xFF, read_len >> 8 }, &cmd)) {
+		return EXIT_FAILURE;
+	}
 
 	ReportData _rsp = {
 			.data        = NULL,
@@ -488,7 +501,7 @@ int do_pip3_file_read_cmd(uint8_t seq_num, uint8_t file_handle,
 	uint8_t rsp_crc_msb;
 	uint8_t rsp_crc_lsb;
 
-	_rsp.data = calloc(_rsp.max_len, 1);
+	_rsp.data = get_pip_arena_buffer(&arena, _rsp.max_len, true);
 	if (_rsp.data == NULL) {
 		output(ERROR, "%s: Memory allocation failed.\n", __func__);
 		return EXIT_FAILURE;
@@ -502,6 +515,15 @@ int do_pip3_file_read_cmd(uint8_t seq_num, uint8_t file_handle,
 		rc = EXIT_FAILURE;
 		goto RETURN;
 	}
+	if (_rsp.len < sizeof(PIP3_Rsp_Header) + read_len
+			+ sizeof(PIP3_Rsp_Footer)) {
+		output(ERROR,
+				"%s: PIP3 FILE_READ response is too short for the %u bytes "
+				"that were asked for (%lu bytes).\n",
+				__func__, read_len, _rsp.len);
+		rc = EXIT_FAILURE;
+		goto RETURN;
+	}
 
 	memcpy((void*) &rsp->header, (void*) _rsp.data, sizeof(PIP3_Rsp_Header));
 
@@ -527,7 +549,7 @@ int do_pip3_file_read_cmd(uint8_t seq_num, uint8_t file_handle,
 	}
 
 RETURN:
-	free(_rsp.data);
+	put_pip_arena_buffer(&arena, _rsp.data);
 	return rc;
 }
 
@@ -545,17 +567,29 @@ int do_pip3_file_write_cmd(uint8_t seq_num, uint8_t file_handle, ByteData* data)
 		return EXIT_FAILURE;
 	}
 
+	if (file_write_max_window > 1) {
+		return _do_pip3_windowed_file_write(seq_num, file_handle, data);
+	}
+
 	ReportData cmd = { .data = NULL };
 	size_t data_part_start_index = 0;
 	bool error_occurred = false;
 	size_t max_data_per_cmd_len;
+	PIP_Encoder encoder;
+	PIP3_File_Write_Context encoder_ctx = {
+			.seq_num     = seq_num,
+			.advance_seq = false,
+			.file_handle = file_handle
+	};
+	uint part_index = 0;
+	uint num_in_place = 0;
 	int rc = EXIT_FAILURE;
 	size_t remaining_data_len = data->len;
 	size_t remaining_num_of_writes;
 
 	cmd.max_len = hid_max_output_report_len - 2;
 	max_data_per_cmd_len = cmd.max_len - PIP3_FILE_WRITE_CMD_WITHOUT_DATA_LEN;
-	cmd.data = malloc(cmd.max_len);
+	cmd.data = get_pip_arena_buffer(&arena, cmd.max_len, false);
 	if (cmd.data == NULL) {
 		output(ERROR, "%s: Memory allocation failed.\n", __func__);
 		return EXIT_FAILURE;
@@ -563,10 +597,16 @@ int do_pip3_file_write_cmd(uint8_t seq_num, uint8_t file_handle, ByteData* data)
 
 	remaining_num_of_writes =
 			(data->len + (max_data_per_cmd_len - 1)) / max_data_per_cmd_len;
+	start_pip_encoder(&encoder, data, max_data_per_cmd_len,
+			_calculate_pip3_file_write_crc, &encoder_ctx);
 
 	while (remaining_data_len > 0 && !error_occurred) {
-		uint16_t cmd_crc;
 		size_t data_part_len;
+		PIP_Overlay overlay;
+		ReportData overlay_cmd = { .max_len = cmd.max_len };
+		ReportData* part_cmd = &cmd;
+		uint16_t crc;
+		bool crc_ready;
 		PIP3_Rsp_Payload_FileWrite rsp;
 		ReportData _rsp = {
 				.data        = (uint8_t*) &rsp,
@@ -579,12 +619,17 @@ int do_pip3_file_write_cmd(uint8_t seq_num, uint8_t file_handle, ByteData* data)
 		data_part_len = ((remaining_data_len > max_data_per_cmd_len)
 				? max_data_per_cmd_len : remaining_data_len);
 
-		cmd.len = data_part_len + PIP3_FILE_WRITE_CMD_WITHOUT_DATA_LEN;
-		if (cmd.len > cmd.max_len) {
-			output(ERROR,
-					"%s: PIP3 Command length (%u bytes) is too large per the "
-					"HID descriptor (%u bytes).\n",
-					__func__, cmd.len, hid_max_output_report_len);
+		crc_ready = get_pip_encoder_crc(&encoder, part_index++, &crc);
+		if (open_pip_overlay(&overlay, data, data_part_start_index,
+				data_part_len, FILE_WRITE_DATA_INDEX, sizeof(PIP3_Cmd_Footer),
+				&overlay_cmd)) {
+			part_cmd = &overlay_cmd;
+			num_in_place++;
+		}
+
+		if (EXIT_SUCCESS != _build_pip3_file_write_cmd(part_cmd, seq_num,
+				file_handle, &data->data[data_part_start_index],
+				data_part_len, crc_ready ? &crc : NULL)) {
 			rc = EXIT_FAILURE;
 			error_occurred = true;
 		}
@@ -592,29 +637,11 @@ int do_pip3_file_write_cmd(uint8_t seq_num, uint8_t file_handle, ByteData* data)
 		if (!error_occurred) {
 			remaining_data_len -= data_part_len;
 
-			PIP3_Cmd_Payload_FileWrite* cmd_data =
-					(PIP3_Cmd_Payload_FileWrite*) cmd.data;
-			uint16_t cmd_payload_len = (uint16_t) cmd.len - 1;
-
-			cmd_data->header.report_id = HID_REPORT_ID_COMMAND;
-			cmd_data->header.payload_len_lsb = cmd_payload_len & 0xFF;
-			cmd_data->header.payload_len_msb = cmd_payload_len >> 8;
-			cmd_data->header.seq = seq_num;
-			cmd_data->header.tag = TAG_BIT;
-			cmd_data->header.more_data = 0;
-			cmd_data->header.reserved_section_1 = 0;
-			cmd_data->header.cmd_id = (uint8_t) PIP3_CMD_ID_FILE_WRITE;
-			cmd_data->header.resp = 0;
-			cmd_data->file_handle = file_handle;
+			rc = do_pip3_command(part_cmd, &_rsp);
+		}
+		close_pip_overlay(&overlay);
 
-			memcpy((void*) &cmd.data[6],
-					(void*) &data->data[data_part_start_index], data_part_len);
-			cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-					cmd.len - 3);
-			cmd.data[cmd.len - 2] = cmd_crc >> 8;
-			cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
-
-			rc = do_pip3_command(&cmd, &_rsp);
+		if (!error_occurred) {
 			if (EXIT_SUCCESS != rc) {
 				output(ERROR,
 						"%s: Aborting the remaining %u FILE_WRITE commands that"
@@ -627,11 +654,19 @@ int do_pip3_file_write_cmd(uint8_t seq_num, uint8_t file_handle, ByteData* data)
 				output(DEBUG,
 					"Remaining number of FILE_WRITE commands to execute: %u.\n",
 					remaining_num_of_writes);
+				if (file_write_progress != NULL) {
+					file_write_progress(data_part_start_index,
+							file_write_progress_context);
+				}
 			}
 		}
 	}
 
-	free(cmd.data);
+	stop_pip_encoder(&encoder);
+	output(DEBUG,
+			"%u FILE_WRITE commands were sent in place from the image.\n",
+			num_in_place);
+	put_pip_arena_buffer(&arena, cmd.data);
 	return rc;
 }
 
@@ -643,41 +678,18 @@ int do_pip3_get_self_test_results_cmd(uint8_t seq_num, uint8_t self_test_id,
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_GetSelfTestResults) - 1;
-	PIP3_Cmd_Payload_GetSelfTestResults cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             =
-									(uint8_t) PIP3_CMD_ID_GET_SELF_TEST_RESULTS,
-					.resp               = 0
-			},
-			.read_offset_lsb = 0x00,
-			.read_offset_msb = 0x00,
-			.read_len_lsb    = 0xFF,
-			.read_len_msb    = 0xFF,
-			.self_test_id    = self_test_id
-	};
+	uint8_t cmd_data[TABLE_CMD_MAX_LEN];
 	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
+			.data    = cmd_data,
+			.max_len = sizeof(cmd_data)
 	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
+	if (EXIT_SUCCESS != _encode_pip3_table_cmd(
+			PIP3_CMD_DESC_GET_SELF_TEST_RESULTS, seq_num,
+			(uint8_t[]) { 0x00, 0x00, 0xFF, 0xFF, self_test_id }, &cmd)) {
+		return EXIT_FAILURE;
+	}
 
 	size_t arl;
 	int rc = EXIT_FAILURE;
@@ -692,7 +704,7 @@ int do_pip3_get_self_test_results_cmd(uint8_t seq_num, uint8_t self_test_id,
 	uint8_t rsp_crc_msb;
 	uint8_t rsp_crc_lsb;
 
-	_rsp.data = (uint8_t*) calloc(max_rsp_size, 1);
+	_rsp.data = (uint8_t*) get_pip_arena_buffer(&arena, max_rsp_size, true);
 	if (_rsp.data == NULL) {
 		output(ERROR, "%s: Memory allocation failed.\n", __func__);
 		return EXIT_FAILURE;
@@ -751,7 +763,7 @@ int do_pip3_get_self_test_results_cmd(uint8_t seq_num, uint8_t self_test_id,
 	rc = EXIT_SUCCESS;
 
 RETURN:
-	free(_rsp.data);
+	put_pip_arena_buffer(&arena, _rsp.data);
 	return rc;
 }
 
@@ -762,45 +774,9 @@ int do_pip3_get_sysinfo_cmd(uint8_t seq_num, PIP3_Rsp_Payload_GetSysinfo* rsp)
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_GetSysinfo) - 1;
-	PIP3_Cmd_Payload_GetSysinfo cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             = (uint8_t) PIP3_CMD_ID_GET_SYSINFO,
-					.resp               = 0
-			}
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(
-			0xFFFF, &(cmd.data[1]), cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
-
-	ReportData _rsp = {
-			.data        = (uint8_t*) rsp,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_GetSysinfo)
-	};
-
-	return do_pip3_command(&cmd, &_rsp);
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_GET_SYSINFO, seq_num, NULL, rsp);
 }
 
 int do_pip3_load_self_test_param_cmd(uint8_t seq_num, uint8_t self_test_id,
@@ -830,7 +806,7 @@ int do_pip3_load_self_test_param_cmd(uint8_t seq_num, uint8_t self_test_id,
 	cmd.max_len = hid_max_output_report_len - 2;
 	max_param_data_per_cmd_len = cmd.max_len
 			- PIP3_LOAD_SELF_TEST_PARAM_CMD_WITHOUT_PARAM_DATA_LEN;
-	cmd.data = malloc(cmd.max_len);
+	cmd.data = get_pip_arena_buffer(&arena, cmd.max_len, false);
 	if (cmd.data == NULL) {
 		output(ERROR, "%s: Memory allocation failed.\n", __func__);
 		return EXIT_FAILURE;
@@ -909,7 +885,7 @@ int do_pip3_load_self_test_param_cmd(uint8_t seq_num, uint8_t self_test_id,
 		}
 	}
 
-	free(cmd.data);
+	put_pip_arena_buffer(&arena, cmd.data);
 	return rc;
 }
 
@@ -921,45 +897,9 @@ int do_pip3_resume_scanning_cmd(uint8_t seq_num,
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_ResumeScanning) - 1;
-	PIP3_Cmd_Payload_ResumeScanning cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             = (uint8_t) PIP3_CMD_ID_RESUME_SCAN,
-					.resp               = 0
-			}
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
-
-	ReportData _rsp = {
-			.data        = (uint8_t*) rsp,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_ResumeScanning)
-	};
-
-	return do_pip3_command(&cmd, &_rsp);
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_RESUME_SCANNING, seq_num, NULL, rsp);
 }
 
 int do_pip3_run_self_test_cmd(uint8_t seq_num, uint8_t self_test_id,
@@ -970,46 +910,10 @@ int do_pip3_run_self_test_cmd(uint8_t seq_num, uint8_t self_test_id,
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_RunSelfTest) - 1;
-	PIP3_Cmd_Payload_RunSelfTest cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             = (uint8_t) PIP3_CMD_ID_RUN_SELF_TEST,
-					.resp               = 0
-			},
-			.self_test_id = self_test_id
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
-
-	ReportData _rsp = {
-			.data        = (uint8_t*) rsp,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_RunSelfTest)
-	};
-
-	return do_pip3_command(&cmd, &_rsp);
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_RUN_SELF_TEST, seq_num,
+			(uint8_t[]) { self_test_id }, rsp);
 }
 
 int do_pip3_start_tracking_heatmap_cmd(uint8_t seq_num,
@@ -1020,11 +924,6 @@ int do_pip3_start_tracking_heatmap_cmd(uint8_t seq_num,
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	} else if (async_debug_data_mode_activated) {
 		output(ERROR,
 				"%s: Asynchronous debug data mode was already activated via the"
@@ -1033,46 +932,14 @@ int do_pip3_start_tracking_heatmap_cmd(uint8_t seq_num,
 		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len =
-			sizeof(PIP3_Cmd_Payload_StartTrackingHeatmap) - 1;
-	PIP3_Cmd_Payload_StartTrackingHeatmap cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             =
-								(uint8_t) PIP3_CMD_ID_START_TRACKING_HEATMAP,
-					.resp               = 0
-			}
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
-
-	ReportData _rsp = {
-			.data        = (uint8_t*) rsp,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_StartTrackingHeatmap)
-	};
-
-	if (EXIT_SUCCESS != do_pip3_command(&cmd, &_rsp)) {
+	if (EXIT_SUCCESS != _do_pip3_table_cmd(PIP3_CMD_DESC_START_TRACKING_HEATMAP,
+			seq_num, NULL, rsp)) {
 		return EXIT_FAILURE;
 	}
 
 	async_debug_data_mode_activated = true;
-	async_debug_data_mode_cmd_id = cmd_data.header.cmd_id;
-	async_debug_data_mode_seq = cmd_data.header.seq;
+	async_debug_data_mode_cmd_id = PIP3_CMD_ID_START_TRACKING_HEATMAP;
+	async_debug_data_mode_seq = seq_num;
 
 	return EXIT_SUCCESS;
 }
@@ -1084,45 +951,9 @@ int do_pip3_status_cmd(uint8_t seq_num, PIP3_Rsp_Payload_Status* rsp)
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_Status) - 1;
-	PIP3_Cmd_Payload_Status cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             = (uint8_t) PIP3_CMD_ID_STATUS,
-					.resp               = 0
-			}
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
-
-	ReportData _rsp = {
-			.data        = (uint8_t*) rsp,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_Status)
-	};
-
-	return do_pip3_command(&cmd, &_rsp);
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_STATUS, seq_num, NULL, rsp);
 }
 
 int do_pip3_stop_async_debug_data_cmd(uint8_t seq_num,
@@ -1133,47 +964,10 @@ int do_pip3_stop_async_debug_data_cmd(uint8_t seq_num,
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len =
-			sizeof(PIP3_Cmd_Payload_StopAsyncDebugData) - 1;
-	PIP3_Cmd_Payload_StopAsyncDebugData cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             =
-									(uint8_t) PIP3_CMD_ID_STOP_ASYNC_DEBUG_DATA,
-					.resp               = 0
-			}
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
-
-	ReportData _rsp = {
-			.data        = (uint8_t*) rsp,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_StopAsyncDebugData)
-	};
-
-	if (EXIT_SUCCESS != do_pip3_command(&cmd, &_rsp)) {
+	if (EXIT_SUCCESS != _do_pip3_table_cmd(PIP3_CMD_DESC_STOP_ASYNC_DEBUG_DATA,
+			seq_num, NULL, rsp)) {
 		return EXIT_FAILURE;
 	}
 
@@ -1190,45 +984,10 @@ int do_pip3_suspend_scanning_cmd(uint8_t seq_num,
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_SuspendScanning) - 1;
-	PIP3_Cmd_Payload_SuspendScanning cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             = (uint8_t) PIP3_CMD_ID_SUSPEND_SCAN,
-					.resp               = 0
-			}
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(
-			0xFFFF, &(cmd.data[1]), cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
-
-	ReportData _rsp = {
-			.data        = (uint8_t*) rsp,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_SuspendScanning)
-	};
-
-	return do_pip3_command(&cmd, &_rsp);
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_SUSPEND_SCANNING, seq_num, NULL,
+			rsp);
 }
 
 #define DELAY_FOR_SWITCH_ACTIVE_PROCESS_CMD_MSECS 2
@@ -1241,32 +1000,16 @@ int do_pip3_switch_active_processor_cmd(uint8_t seq_num,
 			PIP3_PROCESSOR_NAMES[processor_id]);
 	int rc = EXIT_FAILURE;
 
-	uint16_t cmd_payload_len =
-			sizeof(PIP3_Cmd_Payload_SwitchActiveProcessor) - 1;
-	PIP3_Cmd_Payload_SwitchActiveProcessor cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             =
-							(uint8_t) PIP3_CMD_ID_SWITCH_ACTIVE_PROCESSOR,
-					.resp               = 0
-			},
-			.processor_id = (uint8_t) processor_id,
-			.switch_data  = switch_data
-	};
+	uint8_t cmd_data[TABLE_CMD_MAX_LEN];
 	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
+			.data    = cmd_data,
+			.max_len = sizeof(cmd_data)
 	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(
-			0xFFFF, &(cmd.data[1]), cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
+	if (EXIT_SUCCESS != _encode_pip3_table_cmd(
+			PIP3_CMD_DESC_SWITCH_ACTIVE_PROCESSOR, seq_num,
+			(uint8_t[]) { (uint8_t) processor_id, switch_data }, &cmd)) {
+		return EXIT_FAILURE;
+	}
 
 	output_debug_report(REPORT_DIRECTION_OUTGOING_TO_DUT, REPORT_FORMAT_HID,
 			PIP3_CMD_NAMES[PIP3_CMD_ID_SWITCH_ACTIVE_PROCESSOR],
@@ -1291,29 +1034,16 @@ int do_pip3_switch_image_cmd(uint8_t seq_num, PIP3_Image_ID image_id)
 	output(DEBUG, "Switching to the %s image.\n", PIP3_IMAGE_NAMES[image_id]);
 	int rc = EXIT_FAILURE;
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_SwitchImage) - 1;
-	PIP3_Cmd_Payload_SwitchImage cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             = (uint8_t) PIP3_CMD_ID_SWITCH_IMAGE,
-					.resp               = 0
-			},
-			.image_id = (uint8_t) image_id
-	};
+	uint8_t cmd_data[TABLE_CMD_MAX_LEN];
 	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
+			.data    = cmd_data,
+			.max_len = sizeof(cmd_data)
 	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(
-			0xFFFF, &(cmd.data[1]), cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
+	if (EXIT_SUCCESS != _encode_pip3_table_cmd(
+			PIP3_CMD_DESC_SWITCH_IMAGE, seq_num,
+			(uint8_t[]) { (uint8_t) image_id }, &cmd)) {
+		return EXIT_FAILURE;
+	}
 
 	output_debug_report(REPORT_DIRECTION_OUTGOING_TO_DUT, REPORT_FORMAT_HID,
 			PIP3_CMD_NAMES[PIP3_CMD_ID_SWITCH_IMAGE], REPORT_TYPE_COMMAND,
@@ -1337,45 +1067,9 @@ int do_pip3_version_cmd(uint8_t seq_num, PIP3_Rsp_Payload_Version* rsp)
 	if (rsp == NULL) {
 		output(ERROR, "%s: NULL argument provided.\n", __func__);
 		return EXIT_FAILURE;
-	} else if (seq_num > MAX_SEQ_NUM) {
-		output(ERROR,
-				"%s: The sequence number must be less <= 7 (%u was given).\n",
-				__func__, seq_num);
-		return EXIT_FAILURE;
 	}
 
-	uint16_t cmd_payload_len = sizeof(PIP3_Cmd_Payload_Version) - 1;
-	PIP3_Cmd_Payload_Version cmd_data = {
-			.header = {
-					.report_id          = HID_REPORT_ID_COMMAND,
-					.payload_len_lsb    = cmd_payload_len & 0xFF,
-					.payload_len_msb    = cmd_payload_len >> 8,
-					.seq                = seq_num,
-					.tag                = TAG_BIT,
-					.more_data          = 0,
-					.reserved_section_1 = 0,
-					.cmd_id             = (uint8_t) PIP3_CMD_ID_VERSION,
-					.resp               = 0
-			}
-	};
-	ReportData cmd = {
-			.data = (uint8_t*) &cmd_data,
-			.len  = sizeof(cmd_data)
-	};
-	uint16_t cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd.data[1]),
-			cmd.len - 3);
-	cmd.data[cmd.len - 2] = cmd_crc >> 8;
-	cmd.data[cmd.len - 1] = cmd_crc & 0xFF;
-
-	ReportData _rsp = {
-			.data        = (uint8_t*) rsp,
-			.len         = 0,
-			.index       = 0,
-			.num_records = 0,
-			.max_len     = sizeof(PIP3_Rsp_Payload_Version)
-	};
-
-	return do_pip3_command(&cmd, &_rsp);
+	return _do_pip3_table_cmd(PIP3_CMD_DESC_VERSION, seq_num, NULL, rsp);
 }
 
 bool is_pip3_api_active()
@@ -1384,6 +1078,23 @@ bool is_pip3_api_active()
 	return active_channel != NULL && active_channel->type != CHANNEL_TYPE_NONE;
 }
 
+/*
+ * The largest FILE_READ length whose response fits in a single input report.
+ * Each report starts with the report ID and flags bytes, and only the first
+ * 'len - 2' bytes of a report are taken as response payload, so both are
+ * taken off along with the response header and CRC.
+ */
+uint16_t get_pip3_file_read_max_len()
+{
+	return hid_max_input_report_len - 2
+			- HID_INPUT_PIP3_RSP_PAYLOAD_START_BYTE_INDEX - PIP3_RSP_MIN_LEN;
+}
+
+uint get_pip3_file_write_window()
+{
+	return file_write_window;
+}
+
 Poll_Status get_pip3_unsolicited_async_rsp(ReportData* rsp, bool apply_timeout,
 		long double timeout_val)
 {
@@ -1391,7 +1102,8 @@ Poll_Status get_pip3_unsolicited_async_rsp(ReportData* rsp, bool apply_timeout,
 	size_t payload_len = 0;
 	size_t remaining_payload_len = 0;
 	Poll_Status rc;
-	ReportData rsp_report;
+	ReportData* rsp_report;
+	bool report_borrowed = false;
 
 	if (!async_debug_data_mode_activated) {
 		output(ERROR,
@@ -1400,23 +1112,15 @@ Poll_Status get_pip3_unsolicited_async_rsp(ReportData* rsp, bool apply_timeout,
 		return POLL_STATUS_ERROR;
 	}
 
-	rsp_report.data = NULL;
-	rsp_report.max_len = hid_max_input_report_len - 2;
-	rsp_report.data = (uint8_t*) malloc(rsp_report.max_len * sizeof(uint8_t));
-	if (rsp_report.data == NULL) {
-		output(ERROR, "%s: Memory allocation failed. %s [%d].\n", __func__,
-				strerror(errno), errno);
-		return POLL_STATUS_ERROR;
-	}
-
 	do {
 		const HID_Input_PIP3_Response* input_report;
 
-		memset(rsp_report.data, 0, sizeof(rsp_report.max_len));
-		rc = get_report_via_channel(&rsp_report, apply_timeout, timeout_val);
+		rc = borrow_report_via_channel(HID_REPORT_ID_UNSOLICITED_RESPONSE,
+				&rsp_report, apply_timeout, timeout_val);
 
 		if (rc == POLL_STATUS_GOT_DATA) {
-			input_report = (HID_Input_PIP3_Response*) rsp_report.data;
+			report_borrowed = true;
+			input_report = (HID_Input_PIP3_Response*) rsp_report->data;
 			if (EXIT_SUCCESS != _verify_pip3_rsp_report(
 					HID_REPORT_ID_UNSOLICITED_RESPONSE,
 					async_debug_data_mode_seq, async_debug_data_mode_cmd_id,
@@ -1438,15 +1142,15 @@ Poll_Status get_pip3_unsolicited_async_rsp(ReportData* rsp, bool apply_timeout,
 			output_debug_report(REPORT_DIRECTION_INCOMING_FROM_DUT,
 					REPORT_FORMAT_HID,
 					PIP3_CMD_NAMES[async_debug_data_mode_cmd_id],
-					REPORT_TYPE_UNSOLICTED_RESPONSE, &rsp_report);
+					REPORT_TYPE_UNSOLICTED_RESPONSE, rsp_report);
 		} else {
 			output_debug_report(REPORT_DIRECTION_INCOMING_FROM_DUT,
 					REPORT_FORMAT_HID, "(continued response)",
-					REPORT_TYPE_UNSOLICTED_RESPONSE, &rsp_report);
+					REPORT_TYPE_UNSOLICTED_RESPONSE, rsp_report);
 		}
 
 		if (rsp != NULL) {
-			size_t rsp_report_len = rsp_report.len - 2;
+			size_t rsp_report_len = rsp_report->len - 2;
 
 			size_t copy_len = ((remaining_payload_len > rsp_report_len)
 					? rsp_report_len : remaining_payload_len);
@@ -1463,7 +1167,7 @@ Poll_Status get_pip3_unsolicited_async_rsp(ReportData* rsp, bool apply_timeout,
 				rc = POLL_STATUS_ERROR;
 			} else {
 				memcpy(&(rsp->data[rsp->len]),
-						&(rsp_report.data[
+						&(rsp_report->data[
 								HID_INPUT_PIP3_RSP_PAYLOAD_START_BYTE_INDEX]),
 						copy_len);
 
@@ -1471,13 +1175,46 @@ Poll_Status get_pip3_unsolicited_async_rsp(ReportData* rsp, bool apply_timeout,
 				remaining_payload_len -= copy_len;
 			}
 		}
+
+		release_report_via_channel();
+		report_borrowed = false;
 	} while (rc == POLL_STATUS_GOT_DATA && more_reports);
 
 RETURN:
-	free(rsp_report.data);
+	if (report_borrowed) {
+		release_report_via_channel();
+	}
 	return rc;
 }
 
+void set_pip3_file_write_progress(PIP_Write_Progress_Func func, void* context)
+{
+	file_write_progress = func;
+	file_write_progress_context = context;
+}
+
+int set_pip3_file_write_window(uint max_window)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	if (max_window == 0 || max_window > PIP3_FILE_WRITE_MAX_WINDOW) {
+		output(ERROR,
+				"%s: The FILE_WRITE window must be between 1 and %u (%u was "
+				"given).\n",
+				__func__, PIP3_FILE_WRITE_MAX_WINDOW, max_window);
+		return EXIT_FAILURE;
+	}
+
+	file_write_max_window = max_window;
+	file_write_window = 1;
+	return EXIT_SUCCESS;
+}
+
+void set_pip3_fixed_cmd_delay(bool enable)
+{
+	use_fixed_cmd_delay = enable;
+}
+
 int setup_pip3_api(Channel* channel, HID_Report_ID report_id)
 {
 	output(DEBUG, "%s: Starting.\n", __func__);
@@ -1524,7 +1261,13 @@ int setup_pip3_api(Channel* channel, HID_Report_ID report_id)
 	}
 
 	send_report_via_channel = active_channel->send_report;
+	send_reports_via_channel = active_channel->send_reports;
 	get_report_via_channel = active_channel->get_report;
+	num_timed_cmds = 0;
+	device_turnaround_ms = 0;
+	cmd_time_ms = 0;
+	borrow_report_via_channel = active_channel->borrow_report;
+	release_report_via_channel = active_channel->release_report;
 
 	hid_max_input_report_len = hid_desc.max_input_len;
 	hid_max_output_report_len = hid_desc.max_output_len;
@@ -1533,6 +1276,16 @@ int setup_pip3_api(Channel* channel, HID_Report_ID report_id)
 	output(DEBUG, "HID Max Output Report length: %u bytes.\n",
 			hid_max_output_report_len);
 
+	/*
+	 * Sized for a window of FILE_WRITE commands, or any other command, plus
+	 * one response buffer.
+	 */
+	if (EXIT_SUCCESS != init_pip_arena(&arena, PIP_PROTOCOL_PIP3,
+			PIP3_FILE_WRITE_MAX_WINDOW * hid_max_output_report_len
+			+ ARENA_RSP_LEN + 2 * PIP_ARENA_ALIGNMENT)) {
+		return EXIT_FAILURE;
+	}
+
 	return EXIT_SUCCESS;
 }
 
@@ -1553,12 +1306,585 @@ int teardown_pip3_api()
 	 * int rc = do_pip3_resume_scanning_cmd(0x00, &resume_scanning_rsp);
 	 */
 
+	if (num_timed_cmds > 0) {
+		output(DEBUG,
+				"%u PIP3 commands took %.3Lf ms: %.3Lf ms of device turnaround "
+				"and %.3Lf ms of host overhead.\n",
+				num_timed_cmds, cmd_time_ms, device_turnaround_ms,
+				cmd_time_ms - device_turnaround_ms);
+		output(DEBUG,
+				"PIP3 device turnaround: %.3Lf ms min, %.3Lf ms avg, %.3Lf ms "
+				"max, %.3Lf ms jitter.\n",
+				device_turnaround_min_ms, device_turnaround_ms / num_timed_cmds,
+				device_turnaround_max_ms,
+				device_turnaround_max_ms - device_turnaround_min_ms);
+	}
+
 	active_channel->teardown();
 	active_channel = NULL;
+	release_pip_arena(&arena);
+
+	return EXIT_SUCCESS;
+}
+
+/*
+ * A CRC from the encoder thread is used as is when one is given.
+ */
+static int _build_pip3_file_write_cmd(ReportData* cmd, uint8_t seq_num,
+		uint8_t file_handle, const uint8_t* data, size_t data_len,
+		const uint16_t* crc)
+{
+	uint16_t cmd_crc;
+
+	cmd->len = data_len + PIP3_FILE_WRITE_CMD_WITHOUT_DATA_LEN;
+	if (cmd->len > cmd->max_len) {
+		output(ERROR,
+				"%s: PIP3 Command length (%u bytes) is too large per the "
+				"HID descriptor (%u bytes).\n",
+				__func__, cmd->len, hid_max_output_report_len);
+		return EXIT_FAILURE;
+	}
+
+	_fill_pip3_file_write_header(cmd->data, cmd->len, seq_num, file_handle);
+
+	if (&cmd->data[FILE_WRITE_DATA_INDEX] != data) {
+		memcpy((void*) &cmd->data[FILE_WRITE_DATA_INDEX], (void*) data,
+				data_len);
+	}
+	if (crc != NULL) {
+		cmd_crc = *crc;
+	} else {
+		cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd->data[1]),
+				cmd->len - 3);
+	}
+	cmd->data[cmd->len - 2] = cmd_crc >> 8;
+	cmd->data[cmd->len - 1] = cmd_crc & 0xFF;
+
+	return EXIT_SUCCESS;
+}
+
+static uint16_t _calculate_pip3_file_write_crc(uint index,
+		const uint8_t* data, size_t len, void* context)
+{
+	PIP3_File_Write_Context* ctx = (PIP3_File_Write_Context*) context;
+	uint8_t header[FILE_WRITE_DATA_INDEX];
+	uint8_t seq_num = ctx->seq_num;
+	uint16_t crc;
+
+	if (ctx->advance_seq) {
+		seq_num = (seq_num + index) & MAX_SEQ_NUM;
+	}
+
+	_fill_pip3_file_write_header(header,
+			len + PIP3_FILE_WRITE_CMD_WITHOUT_DATA_LEN, seq_num,
+			ctx->file_handle);
+	crc = calculate_crc16_ccitt(0xFFFF, &header[1], sizeof(header) - 1);
+	return calculate_crc16_ccitt(crc, (uint8_t*) data, len);
+}
+
+static void _discard_pip3_rsps()
+{
+	ReportData* rsp_report;
+
+	while (POLL_STATUS_GOT_DATA == borrow_report_via_channel(
+			HID_REPORT_ID_SOLICITED_RESPONSE, &rsp_report, true,
+			DISCARD_RSP_TIMEOUT)) {
+		output_debug_report(REPORT_DIRECTION_INCOMING_FROM_DUT,
+				REPORT_FORMAT_HID, "(discarded response)", REPORT_TYPE_RESPONSE,
+				rsp_report);
+		release_report_via_channel();
+	}
+}
+
+static int _do_pip3_command(ReportData* cmd, ReportData* rsp,
+		long double timeout)
+{
+	const HID_Output_PIP3_Command* output_report;
+	int rc;
+	struct timespec cpu_start_time;
+	struct timespec cpu_end_time;
+	struct timespec cmd_start_time;
+	struct timespec cmd_end_time;
+	PIP3_Rsp_Timing rsp_timing = { .received = false };
+
+	output_report = (HID_Output_PIP3_Command*) cmd->data;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start_time);
+	clock_gettime(CLOCK_MONOTONIC, &cmd_start_time);
+
+	output_debug_report(REPORT_DIRECTION_OUTGOING_TO_DUT, REPORT_FORMAT_HID,
+			PIP3_CMD_NAMES[output_report->cmd_id], REPORT_TYPE_COMMAND, cmd);
+	rc = send_report_via_channel(cmd);
+	if (rc == EXIT_SUCCESS) {
+		if (use_fixed_cmd_delay) {
+			sleep_ms(AVG_DELAY_BETWEEN_CMD_AND_RSP);
+		}
+		rc = _get_pip3_rsp(output_report->cmd_id, output_report->seq, rsp,
+				timeout, &rsp_timing);
+	}
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end_time);
+	clock_gettime(CLOCK_MONOTONIC, &cmd_end_time);
+	output(DEBUG, "PIP3 %s command used %.3Lf ms of host CPU time.\n",
+			PIP3_CMD_NAMES[output_report->cmd_id],
+			((cpu_end_time.tv_sec - cpu_start_time.tv_sec) * 1e3L
+			+ (cpu_end_time.tv_nsec - cpu_start_time.tv_nsec) / 1e6L));
+
+	_record_pip3_cmd_time(output_report->cmd_id, &cmd_start_time,
+			&cmd->timestamp, &rsp_timing, &cmd_end_time);
+	return rc;
+}
+
+static int _do_pip3_table_cmd(PIP3_Cmd_Desc_ID desc_id, uint8_t seq_num,
+		const uint8_t* params, void* rsp)
+{
+	const PIP3_Cmd_Desc* desc = &PIP3_CMD_DESCS[desc_id];
+	uint8_t cmd_data[TABLE_CMD_MAX_LEN];
+	ReportData cmd = {
+			.data    = cmd_data,
+			.max_len = sizeof(cmd_data)
+	};
+	ReportData _rsp = {
+			.data        = (uint8_t*) rsp,
+			.len         = 0,
+			.index       = 0,
+			.num_records = 0,
+			.max_len     = desc->rsp_len
+	};
+
+	if (EXIT_SUCCESS != _encode_pip3_table_cmd(desc_id, seq_num, params,
+			&cmd)) {
+		return EXIT_FAILURE;
+	}
+
+	return _do_pip3_command(&cmd, &_rsp, PIP3_TIMEOUTS[desc->timeout_class]);
+}
+
+/*
+ * Keeps up to 'file_write_window' FILE_WRITE commands outstanding, each with
+ * the next SEQ number, and matches the responses to them in order. A failure
+ * cannot be recovered in place because the device file pointer has already
+ * moved past the outstanding commands, so the window is halved and the caller
+ * has to rewrite the file.
+ */
+static int _do_pip3_windowed_file_write(uint8_t seq_num, uint8_t file_handle,
+		ByteData* data)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	ReportData cmds[PIP3_FILE_WRITE_MAX_WINDOW];
+	struct timespec cmd_start_times[PIP3_FILE_WRITE_MAX_WINDOW];
+	uint8_t* cmd_buffer;
+	size_t cmd_max_len = hid_max_output_report_len - 2;
+	size_t max_data_per_cmd_len =
+			cmd_max_len - PIP3_FILE_WRITE_CMD_WITHOUT_DATA_LEN;
+	size_t num_of_writes =
+			(data->len + (max_data_per_cmd_len - 1)) / max_data_per_cmd_len;
+	size_t num_sent = 0;
+	size_t num_acked = 0;
+	uint num_acked_in_window = 0;
+	uint num_in_place = 0;
+	PIP_Encoder encoder;
+	PIP3_File_Write_Context encoder_ctx = {
+			.seq_num     = seq_num,
+			.advance_seq = true,
+			.file_handle = file_handle
+	};
+	int rc = EXIT_SUCCESS;
+
+	cmd_buffer = get_pip_arena_buffer(&arena,
+			PIP3_FILE_WRITE_MAX_WINDOW * cmd_max_len, false);
+	if (cmd_buffer == NULL) {
+		output(ERROR, "%s: Memory allocation failed.\n", __func__);
+		return EXIT_FAILURE;
+	}
+
+	for (int i = 0; i < PIP3_FILE_WRITE_MAX_WINDOW; i++) {
+		cmds[i].data = &cmd_buffer[i * cmd_max_len];
+		cmds[i].max_len = cmd_max_len;
+	}
+
+	output(DEBUG, "Writing %u FILE_WRITE commands with a window of %u.\n",
+			num_of_writes, file_write_window);
+	start_pip_encoder(&encoder, data, max_data_per_cmd_len,
+			_calculate_pip3_file_write_crc, &encoder_ctx);
+
+	while (num_acked < num_of_writes && rc == EXIT_SUCCESS) {
+		/*
+		 * The window is refilled once at least half of it is free, and the
+		 * commands that refill it are handed to the channel in one call, so
+		 * a batching transport such as io_uring submits them together.
+		 */
+		uint window_room = file_write_window - (num_sent - num_acked);
+		uint num_batched = 0;
+		if (num_sent == num_acked || 2 * window_room >= file_write_window) {
+			num_batched = window_room;
+			if (num_batched > num_of_writes - num_sent) {
+				num_batched = num_of_writes - num_sent;
+			}
+		}
+
+		if (num_batched > 0) {
+			ReportData batch[PIP3_FILE_WRITE_MAX_WINDOW];
+			PIP_Overlay overlays[PIP3_FILE_WRITE_MAX_WINDOW];
+			uint16_t crcs[PIP3_FILE_WRITE_MAX_WINDOW];
+			bool crcs_ready[PIP3_FILE_WRITE_MAX_WINDOW];
+			struct timespec batch_start_time = { 0 };
+
+			/*
+			 * Neighbouring commands cannot both be laid out in place, as the
+			 * header of one is written over the end of the other. Every other
+			 * command of the batch is therefore built in its own buffer, and
+			 * those are built first while the image is still untouched. The
+			 * encoder has calculated the CRC of the part after the last one
+			 * by the time that CRC has been taken.
+			 */
+			for (uint i = 0; i < num_batched; i++) {
+				size_t offset = (num_sent + i) * max_data_per_cmd_len;
+				size_t data_part_len = data->len - offset;
+				if (data_part_len > max_data_per_cmd_len) {
+					data_part_len = max_data_per_cmd_len;
+				}
+
+				crcs_ready[i] = get_pip_encoder_crc(&encoder, num_sent + i,
+						&crcs[i]);
+				batch[i] = cmds[(num_sent + i) % PIP3_FILE_WRITE_MAX_WINDOW];
+				overlays[i].head = NULL;
+				if ((i == 0 || overlays[i - 1].head == NULL)
+						&& open_pip_overlay(&overlays[i], data, offset,
+								data_part_len, FILE_WRITE_DATA_INDEX,
+								sizeof(PIP3_Cmd_Footer), &batch[i])) {
+					num_in_place++;
+				}
+			}
+
+			for (uint pass = 0; pass < 2 && rc == EXIT_SUCCESS; pass++) {
+				for (uint i = 0; i < num_batched && rc == EXIT_SUCCESS; i++) {
+					size_t offset = (num_sent + i) * max_data_per_cmd_len;
+					size_t data_part_len = data->len - offset;
+					if ((overlays[i].head != NULL) != (pass == 1)) {
+						continue;
+					}
+					if (data_part_len > max_data_per_cmd_len) {
+						data_part_len = max_data_per_cmd_len;
+					}
+
+					rc = _build_pip3_file_write_cmd(&batch[i],
+							(seq_num + num_sent + i) & MAX_SEQ_NUM,
+							file_handle, &data->data[offset], data_part_len,
+							crcs_ready[i] ? &crcs[i] : NULL);
+				}
+			}
+
+			if (rc == EXIT_SUCCESS) {
+				for (uint i = 0; i < num_batched; i++) {
+					output_debug_report(REPORT_DIRECTION_OUTGOING_TO_DUT,
+							REPORT_FORMAT_HID,
+							PIP3_CMD_NAMES[PIP3_CMD_ID_FILE_WRITE],
+							REPORT_TYPE_COMMAND, &batch[i]);
+				}
+				clock_gettime(CLOCK_MONOTONIC, &batch_start_time);
+				rc = send_reports_via_channel(batch, num_batched);
+			}
+
+			for (uint i = 0; i < num_batched; i++) {
+				uint window_index = (num_sent + i) % PIP3_FILE_WRITE_MAX_WINDOW;
+				cmds[window_index].timestamp = batch[i].timestamp;
+				cmd_start_times[window_index] = batch_start_time;
+				close_pip_overlay(&overlays[i]);
+			}
+
+			if (rc == EXIT_SUCCESS) {
+				num_sent += num_batched;
+			}
+		}
+
+		if (rc != EXIT_SUCCESS) {
+			break;
+		}
+
+		ReportData* cmd = &cmds[num_acked % PIP3_FILE_WRITE_MAX_WINDOW];
+		PIP3_Rsp_Payload_FileWrite rsp;
+		ReportData _rsp = {
+				.data        = (uint8_t*) &rsp,
+				.len         = 0,
+				.index       = 0,
+				.num_records = 0,
+				.max_len     = sizeof(PIP3_Rsp_Payload_FileWrite)
+		};
+		PIP3_Rsp_Timing rsp_timing = { .received = false };
+		struct timespec cmd_end_time;
+
+		rc = _get_pip3_rsp(PIP3_CMD_ID_FILE_WRITE,
+				(seq_num + num_acked) & MAX_SEQ_NUM, &_rsp,
+				PIP3_TIMEOUTS[PIP3_TIMEOUT_CLASS_DEFAULT], &rsp_timing);
+		clock_gettime(CLOCK_MONOTONIC, &cmd_end_time);
+		_record_pip3_cmd_time(PIP3_CMD_ID_FILE_WRITE,
+				&cmd_start_times[num_acked % PIP3_FILE_WRITE_MAX_WINDOW],
+				&cmd->timestamp, &rsp_timing, &cmd_end_time);
+		if (rc != EXIT_SUCCESS) {
+			break;
+		}
+
+		num_acked++;
+		num_acked_in_window++;
+		if (file_write_progress != NULL) {
+			file_write_progress((num_acked < num_of_writes)
+					? num_acked * max_data_per_cmd_len : data->len,
+					file_write_progress_context);
+		}
+		if (num_acked_in_window >= file_write_window
+				&& file_write_window < file_write_max_window) {
+			file_write_window++;
+			num_acked_in_window = 0;
+			output(DEBUG, "FILE_WRITE window increased to %u.\n",
+					file_write_window);
+		}
+	}
+
+	if (rc != EXIT_SUCCESS) {
+		output(ERROR,
+				"%s: Aborting the remaining %u FILE_WRITE commands that are "
+				"pending execution (%u outstanding).\n",
+				__func__, num_of_writes - num_acked, num_sent - num_acked);
+		_discard_pip3_rsps();
+
+		if (file_write_window > 1) {
+			file_write_window /= 2;
+			output(WARNING, "FILE_WRITE window reduced to %u.\n",
+					file_write_window);
+		}
+	}
+
+	stop_pip_encoder(&encoder);
+	output(DEBUG,
+			"%u FILE_WRITE commands were sent in place from the image.\n",
+			num_in_place);
+	put_pip_arena_buffer(&arena, cmd_buffer);
+	return rc;
+}
+
+static int _encode_pip3_table_cmd(PIP3_Cmd_Desc_ID desc_id, uint8_t seq_num,
+		const uint8_t* params, ReportData* cmd)
+{
+	const PIP3_Cmd_Desc* desc = &PIP3_CMD_DESCS[desc_id];
+	PIP3_Cmd_Header* header = (PIP3_Cmd_Header*) cmd->data;
+	size_t params_len = desc->cmd_len - sizeof(PIP3_Cmd_Header)
+			- sizeof(PIP3_Cmd_Footer);
+	uint16_t cmd_payload_len = desc->cmd_len - 1;
+	uint16_t cmd_crc;
+
+	if (seq_num > MAX_SEQ_NUM) {
+		output(ERROR,
+				"%s: The sequence number must be less <= 7 (%u was given).\n",
+				__func__, seq_num);
+		return EXIT_FAILURE;
+	} else if (desc->cmd_len > cmd->max_len) {
+		output(ERROR,
+				"%s: The PIP3 %s command (%u bytes) does not fit in the "
+				"command buffer (%u bytes).\n",
+				__func__, PIP3_CMD_NAMES[desc->cmd_id], desc->cmd_len,
+				cmd->max_len);
+		return EXIT_FAILURE;
+	}
+
+	header->report_id = HID_REPORT_ID_COMMAND;
+	header->payload_len_lsb = cmd_payload_len & 0xFF;
+	header->payload_len_msb = cmd_payload_len >> 8;
+	header->seq = seq_num;
+	header->tag = TAG_BIT;
+	header->more_data = 0;
+	header->reserved_section_1 = 0;
+	header->cmd_id = (uint8_t) desc->cmd_id;
+	header->resp = 0;
+	if (params_len > 0) {
+		memcpy(&cmd->data[sizeof(PIP3_Cmd_Header)], params, params_len);
+	}
+	cmd->len = desc->cmd_len;
+
+	if (desc->crcs != NULL) {
+		cmd_crc = desc->crcs[seq_num];
+	} else {
+		cmd_crc = calculate_crc16_ccitt(0xFFFF, &(cmd->data[1]), cmd->len - 3);
+	}
+	cmd->data[cmd->len - 2] = cmd_crc >> 8;
+	cmd->data[cmd->len - 1] = cmd_crc & 0xFF;
 
 	return EXIT_SUCCESS;
 }
 
+static void _fill_pip3_file_write_header(uint8_t* cmd_data, size_t cmd_len,
+		uint8_t seq_num, uint8_t file_handle)
+{
+	PIP3_Cmd_Header* header = (PIP3_Cmd_Header*) cmd_data;
+	uint16_t cmd_payload_len = (uint16_t) cmd_len - 1;
+
+	header->report_id = HID_REPORT_ID_COMMAND;
+	header->payload_len_lsb = cmd_payload_len & 0xFF;
+	header->payload_len_msb = cmd_payload_len >> 8;
+	header->seq = seq_num;
+	header->tag = TAG_BIT;
+	header->more_data = 0;
+	header->reserved_section_1 = 0;
+	header->cmd_id = (uint8_t) PIP3_CMD_ID_FILE_WRITE;
+	header->resp = 0;
+	cmd_data[sizeof(PIP3_Cmd_Header)] = file_handle;
+}
+
+static int _get_pip3_rsp(PIP3_Cmd_ID cmd_id, uint8_t seq, ReportData* rsp,
+		long double timeout, PIP3_Rsp_Timing* timing)
+{
+	bool more_reports = false;
+	size_t payload_len = 0;
+	size_t remaining_payload_len = 0;
+	int rc = EXIT_SUCCESS;
+	Poll_Status read_rc;
+	ReportData* rsp_report;
+	bool report_borrowed = false;
+
+	do {
+		const HID_Input_PIP3_Response* input_report;
+
+		read_rc = borrow_report_via_channel(HID_REPORT_ID_SOLICITED_RESPONSE,
+				&rsp_report, true, timeout);
+		switch (read_rc) {
+		case POLL_STATUS_GOT_DATA:
+			report_borrowed = true;
+			break;
+		case POLL_STATUS_TIMEOUT:
+			output(ERROR,
+					"%s: Timed-Out waiting for PIP3 %s Response.\n",
+					__func__, PIP3_CMD_NAMES[cmd_id]);
+			timing->timed_out = true;
+			rc = EXIT_FAILURE;
+			break;
+		case POLL_STATUS_ERROR:
+			output(ERROR,
+					"%s: Unexpected error occurred while attempting to retrieve"
+					" the PIP3 %s Response.\n",
+					__func__, PIP3_CMD_NAMES[cmd_id]);
+			rc = EXIT_FAILURE;
+			break;
+		default:
+			output(ERROR,
+					"%s: Unexpected 'Poll_Status' enum value (%d) for pending "
+					"PIP3 %s Response.\n",
+					__func__, read_rc, PIP3_CMD_NAMES[cmd_id]);
+			rc = EXIT_FAILURE;
+		}
+
+		if (rc == EXIT_SUCCESS) {
+			input_report = (HID_Input_PIP3_Response*) rsp_report->data;
+			rc = _verify_pip3_rsp_report(HID_REPORT_ID_SOLICITED_RESPONSE,
+					seq, cmd_id, input_report);
+		}
+
+		if (rc != EXIT_SUCCESS) {
+			goto RETURN;
+		}
+
+		if (!timing->received) {
+			timing->first_report_time = rsp_report->timestamp;
+			timing->received = true;
+		}
+		timing->last_report_time = rsp_report->timestamp;
+
+		more_reports = input_report->more_reports;
+		if (input_report->first_report == 1) {
+			payload_len = ((input_report->payload_len_msb << 8)
+					| input_report->payload_len_lsb);
+			remaining_payload_len = payload_len;
+			output(DEBUG, "Payload Length: %u\n", payload_len);
+			output_debug_report(REPORT_DIRECTION_INCOMING_FROM_DUT,
+					REPORT_FORMAT_HID, PIP3_CMD_NAMES[cmd_id],
+					REPORT_TYPE_RESPONSE, rsp_report);
+		} else {
+			output_debug_report(REPORT_DIRECTION_INCOMING_FROM_DUT,
+					REPORT_FORMAT_HID, "(continued response)",
+					REPORT_TYPE_RESPONSE, rsp_report);
+		}
+
+		if (rsp != NULL) {
+			size_t rsp_report_len = rsp_report->len - 2;
+
+			size_t copy_len = ((remaining_payload_len > rsp_report_len)
+					? rsp_report_len : remaining_payload_len);
+
+			if (payload_len > rsp->max_len) {
+				output(ERROR, "%s: The response payload is larger (%u bytes) "
+						"than the maximum size supported (%u bytes).\n",
+						__func__, payload_len, rsp->max_len);
+				rc = EXIT_FAILURE;
+			} else if (copy_len + rsp->len > payload_len) {
+				output(ERROR, "%s: The response reports added up to a larger "
+						"total paylaod (%u) than expected (%u bytes).\n",
+						__func__, copy_len + rsp->len, payload_len);
+				rc = EXIT_FAILURE;
+			} else {
+				memcpy(&(rsp->data[rsp->len]),
+						&(rsp_report->data[
+								HID_INPUT_PIP3_RSP_PAYLOAD_START_BYTE_INDEX]),
+						copy_len);
+
+				rsp->len += copy_len;
+				remaining_payload_len -= copy_len;
+			}
+		}
+
+		release_report_via_channel();
+		report_borrowed = false;
+	} while (rc == EXIT_SUCCESS && more_reports);
+
+RETURN:
+	if (report_borrowed) {
+		release_report_via_channel();
+	}
+
+	return rc;
+}
+
+/*
+ * The device turnaround is measured from the moment the command was written
+ * until the last report of its response was read, so the rest of the command
+ * time is host overhead. For the latency histograms the command time is split
+ * into sending, waiting for the first response report and reassembling the
+ * rest of the response.
+ */
+static void _record_pip3_cmd_time(PIP3_Cmd_ID cmd_id,
+		const struct timespec* start_time, const struct timespec* send_time,
+		const PIP3_Rsp_Timing* timing, const struct timespec* end_time)
+{
+	if (timing->timed_out) {
+		record_pip_cmd(PIP_PROTOCOL_PIP3, cmd_id, 0, 0, 0, true);
+		return;
+	} else if (!timing->received) {
+		return;
+	}
+
+	long double total_ms = get_timespec_diff_ms(start_time, end_time);
+	long double turnaround_ms = get_timespec_diff_ms(send_time,
+			&timing->last_report_time);
+
+	output(DEBUG,
+			"PIP3 %s command took %.3Lf ms: first response report after "
+			"%.3Lf ms, device turnaround %.3Lf ms.\n",
+			PIP3_CMD_NAMES[cmd_id], total_ms,
+			get_timespec_diff_ms(send_time, &timing->first_report_time),
+			turnaround_ms);
+	if (num_timed_cmds == 0 || turnaround_ms < device_turnaround_min_ms) {
+		device_turnaround_min_ms = turnaround_ms;
+	}
+	if (num_timed_cmds == 0 || turnaround_ms > device_turnaround_max_ms) {
+		device_turnaround_max_ms = turnaround_ms;
+	}
+	num_timed_cmds++;
+	device_turnaround_ms += turnaround_ms;
+	cmd_time_ms += total_ms;
+
+	record_pip_cmd(PIP_PROTOCOL_PIP3, cmd_id,
+			get_timespec_diff_ms(start_time, send_time),
+			get_timespec_diff_ms(send_time, &timing->first_report_time),
+			get_timespec_diff_ms(&timing->first_report_time, end_time), false);
+}
+
 static int _verify_pip3_rsp_report(HID_Report_ID report_id, uint8_t seq,
 		PIP3_Cmd_ID cmd_id, const HID_Input_PIP3_Response* rsp)
 {
@@ -8,6 +8,10 @@
 #include "pip3_cmd_id.h"
 #include "pip3_self_test_id.h"
 #include "pip3_status_code.h"
+#include "pip_arena.h"
+#include "pip_encoder.h"
+#include "pip_overlay.h"
+#include "pip_stats.h"
 #include "../base64.h"
 #include "../crc16_ccitt.h"
 #include "../channel/channel.h"
@@ -167,6 +171,52 @@ typedef struct {
 	PIP3_Rsp_Footer footer;
 } __attribute__((packed)) PIP3_Rsp_Payload_FileIOCTL_EraseFile;
 
+typedef struct {
+	PIP3_Cmd_Header header;
+	uint8_t file_handle;
+	uint8_t ioctl_code;
+	uint8_t offset[4];
+	uint8_t len[4];
+	PIP3_Cmd_Footer footer;
+} __attribute__((packed)) PIP3_Cmd_Payload_FileIOCTL_FileCRC;
+
+typedef struct {
+	PIP3_Rsp_Header header;
+	uint8_t crc_lsb;
+	uint8_t crc_msb;
+	PIP3_Rsp_Footer footer;
+} __attribute__((packed)) PIP3_Rsp_Payload_FileIOCTL_FileCRC;
+
+typedef struct {
+	PIP3_Cmd_Header header;
+	uint8_t file_handle;
+	uint8_t ioctl_code;
+	PIP3_Cmd_Footer footer;
+} __attribute__((packed)) PIP3_Cmd_Payload_FileIOCTL_FileStats;
+
+typedef struct {
+	PIP3_Rsp_Header header;
+	uint8_t address[4];
+	uint8_t file_size[4];
+	PIP3_Rsp_Footer footer;
+} __attribute__((packed)) PIP3_Rsp_Payload_FileIOCTL_FileStats;
+
+typedef struct {
+	PIP3_Cmd_Header header;
+	uint8_t file_handle;
+	uint8_t ioctl_code;
+	uint8_t read_offset[4];
+	uint8_t write_offset[4];
+	PIP3_Cmd_Footer footer;
+} __attribute__((packed)) PIP3_Cmd_Payload_FileIOCTL_SeekFilePointers;
+
+typedef struct {
+	PIP3_Rsp_Header header;
+	uint8_t read_offset[4];
+	uint8_t write_offset[4];
+	PIP3_Rsp_Footer footer;
+} __attribute__((packed)) PIP3_Rsp_Payload_FileIOCTL_SeekFilePointers;
+
 typedef struct {
 	PIP3_Cmd_Header header;
 	uint8_t file_num;
@@ -446,10 +496,19 @@ typedef struct {
 	PIP3_Rsp_Footer footer;
 } __attribute__((packed)) PIP3_Rsp_Payload_Version;
 
-extern int (*send_report_via_channel)(const ReportData* report);
+#define PIP3_FILE_WRITE_MAX_WINDOW 8
+
+extern int (*send_report_via_channel)(ReportData* report);
+extern int (*send_reports_via_channel)(ReportData* reports,
+		uint num_reports);
+
+extern Poll_Status (*get_report_via_channel)(HID_Report_ID report_id,
+		ReportData* report, bool apply_timeout, long double timeout_val);
+
+extern Poll_Status (*borrow_report_via_channel)(HID_Report_ID report_id,
+		ReportData** report, bool apply_timeout, long double timeout_val);
 
-extern Poll_Status (*get_report_via_channel)(ReportData* report, bool apply_timeout,
-		long double timeout_val);
+extern void (*release_report_via_channel)();
 
 extern int do_pip3_command(ReportData* cmd, ReportData* rsp);
 extern int do_pip3_calibrate_cmd(uint8_t seq_num, uint8_t calibrate_mode,
@@ -459,8 +518,15 @@ extern int do_pip3_initialize_baselines_cmd(uint8_t seq_num,
 		uint8_t data_id_mask, PIP3_Rsp_Payload_InitializeBaselines* rsp);
 extern int do_pip3_file_close_cmd(uint8_t seq_num, uint8_t file_handle,
 		PIP3_Rsp_Payload_FileClose* rsp);
+extern int do_pip3_file_ioctl_crc_cmd(uint8_t seq_num, uint8_t file_handle,
+		uint32_t offset, uint32_t len, PIP3_Rsp_Payload_FileIOCTL_FileCRC* rsp);
 extern int do_pip3_file_ioctl_erase_file_cmd(uint8_t seq_num,
 		uint8_t file_handle, PIP3_Rsp_Payload_FileIOCTL_EraseFile* rsp);
+extern int do_pip3_file_ioctl_file_stats_cmd(uint8_t seq_num,
+		uint8_t file_handle, PIP3_Rsp_Payload_FileIOCTL_FileStats* rsp);
+extern int do_pip3_file_ioctl_seek_file_pointers_cmd(uint8_t seq_num,
+		uint8_t file_handle, uint32_t read_offset, uint32_t write_offset,
+		PIP3_Rsp_Payload_FileIOCTL_SeekFilePointers* rsp);
 extern int do_pip3_file_open_cmd(uint8_t seq_num, uint8_t file_num,
 		PIP3_Rsp_Payload_FileOpen* rsp);
 extern int do_pip3_file_read_cmd(uint8_t seq_num, uint8_t file_handle,
@@ -489,9 +555,15 @@ extern int do_pip3_switch_active_processor_cmd(uint8_t seq_num,
 		PIP3_Processor_ID processor_id, uint8_t switch_data);
 extern int do_pip3_switch_image_cmd(uint8_t seq_num, PIP3_Image_ID image_id);
 extern int do_pip3_version_cmd(uint8_t seq_num, PIP3_Rsp_Payload_Version* rsp);
+extern uint16_t get_pip3_file_read_max_len();
+extern uint get_pip3_file_write_window();
 extern Poll_Status get_pip3_unsolicited_async_rsp(ReportData* rsp,
 		bool apply_timeout, long double timeout_val);
 extern bool is_pip3_api_active();
+extern void set_pip3_file_write_progress(PIP_Write_Progress_Func func,
+		void* context);
+extern int set_pip3_file_write_window(uint max_window);
+extern void set_pip3_fixed_cmd_delay(bool enable);
 extern int setup_pip3_api(Channel* channel, HID_Report_ID report_id);
 extern int teardown_pip3_api();
 
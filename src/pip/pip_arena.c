@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#include "pip_arena.h"
+
+static size_t _align_len(size_t len);
+
+void* get_pip_arena_buffer(PIP_Arena* arena, size_t len, bool zero)
+{
+	void* buffer;
+	size_t aligned_len = _align_len(len);
+
+	if (arena->base != NULL && aligned_len <= arena->size - arena->used) {
+		buffer = &arena->base[arena->used];
+		arena->used += aligned_len;
+		if (zero) {
+			memset(buffer, 0, len);
+		}
+		record_pip_buffer_alloc(arena->protocol, false, arena->used);
+		return buffer;
+	}
+
+	buffer = zero ? calloc(len, 1) : malloc(len);
+	if (buffer != NULL) {
+		record_pip_buffer_alloc(arena->protocol, true, arena->used);
+	}
+	return buffer;
+}
+
+int init_pip_arena(PIP_Arena* arena, PIP_Protocol protocol, size_t size)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	arena->size = _align_len(size);
+	arena->used = 0;
+	arena->protocol = protocol;
+	if (0 != posix_memalign((void**) &arena->base, PIP_ARENA_ALIGNMENT,
+			arena->size)) {
+		output(ERROR, "%s: Memory allocation failed.\n", __func__);
+		arena->base = NULL;
+		arena->size = 0;
+		return EXIT_FAILURE;
+	}
+
+	output(DEBUG, "Allocated a %lu byte %s buffer arena.\n", arena->size,
+			(protocol == PIP_PROTOCOL_PIP2) ? "PIP2" : "PIP3");
+	return EXIT_SUCCESS;
+}
+
+void put_pip_arena_buffer(PIP_Arena* arena, void* buffer)
+{
+	uint8_t* _buffer = (uint8_t*) buffer;
+
+	if (arena->base != NULL && _buffer >= arena->base
+			&& _buffer < &arena->base[arena->size]) {
+		arena->used = _buffer - arena->base;
+	} else {
+		free(buffer);
+	}
+}
+
+void release_pip_arena(PIP_Arena* arena)
+{
+	free(arena->base);
+	arena->base = NULL;
+	arena->size = 0;
+	arena->used = 0;
+}
+
+static size_t _align_len(size_t len)
+{
+	return ((len + PIP_ARENA_ALIGNMENT - 1) / PIP_ARENA_ALIGNMENT)
+			* PIP_ARENA_ALIGNMENT;
+}
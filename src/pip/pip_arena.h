@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#ifndef PTLIB_PIP_PIP_ARENA_H_
+#define PTLIB_PIP_PIP_ARENA_H_
+
+#include "../logging.h"
+#include <stdint.h>
+#include "pip_stats.h"
+
+#define PIP_ARENA_ALIGNMENT 64
+
+/*
+ * A session-scoped stack of command and response buffers. Buffers have to be
+ * put back in the reverse order they were taken. When the arena is not set up
+ * or is too small the buffer comes from the heap instead.
+ */
+typedef struct {
+	uint8_t* base;
+	size_t size;
+	size_t used;
+	PIP_Protocol protocol;
+} PIP_Arena;
+
+extern void* get_pip_arena_buffer(PIP_Arena* arena, size_t len, bool zero);
+extern int init_pip_arena(PIP_Arena* arena, PIP_Protocol protocol,
+		size_t size);
+extern void put_pip_arena_buffer(PIP_Arena* arena, void* buffer);
+extern void release_pip_arena(PIP_Arena* arena);
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#include "pip_encoder.h"
+
+static void* _run_pip_encoder(void* arg);
+
+/*
+ * Returns false when the worker is not running, in which case the caller has
+ * to calculate the CRC itself.
+ */
+bool get_pip_encoder_crc(PIP_Encoder* encoder, uint index, uint16_t* crc)
+{
+	uint needed = index + 2;
+
+	if (!encoder->running || index >= encoder->num_parts) {
+		return false;
+	}
+
+	if (needed > encoder->num_parts) {
+		needed = encoder->num_parts;
+	}
+
+	pthread_mutex_lock(&encoder->lock);
+	while (encoder->num_produced < needed) {
+		pthread_cond_wait(&encoder->cond, &encoder->lock);
+	}
+	*crc = encoder->crcs[index % PIP_ENCODER_DEPTH];
+	encoder->num_consumed = index + 1;
+	pthread_cond_broadcast(&encoder->cond);
+	pthread_mutex_unlock(&encoder->lock);
+
+	return true;
+}
+
+int start_pip_encoder(PIP_Encoder* encoder, const ByteData* image,
+		size_t part_len, PIP_Part_CRC_Func crc_func, void* context)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	encoder->running = false;
+	encoder->stop = false;
+	encoder->image = image;
+	encoder->part_len = part_len;
+	encoder->num_parts = (image->len + (part_len - 1)) / part_len;
+	encoder->num_produced = 0;
+	encoder->num_consumed = 0;
+	encoder->crc_func = crc_func;
+	encoder->context = context;
+
+	pthread_mutex_init(&encoder->lock, NULL);
+	pthread_cond_init(&encoder->cond, NULL);
+
+	int rc = pthread_create(&encoder->thread, NULL, _run_pip_encoder,
+			encoder);
+	if (rc != 0) {
+		output(WARNING,
+				"%s: Failed to start the encoder thread, so CRCs will be "
+				"calculated by the sender. %s [%d]\n",
+				__func__, strerror(rc), rc);
+		pthread_cond_destroy(&encoder->cond);
+		pthread_mutex_destroy(&encoder->lock);
+		return EXIT_FAILURE;
+	}
+
+	encoder->running = true;
+	return EXIT_SUCCESS;
+}
+
+void stop_pip_encoder(PIP_Encoder* encoder)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	if (!encoder->running) {
+		return;
+	}
+
+	pthread_mutex_lock(&encoder->lock);
+	encoder->stop = true;
+	pthread_cond_broadcast(&encoder->cond);
+	pthread_mutex_unlock(&encoder->lock);
+
+	pthread_join(encoder->thread, NULL);
+	pthread_cond_destroy(&encoder->cond);
+	pthread_mutex_destroy(&encoder->lock);
+	encoder->running = false;
+}
+
+static void* _run_pip_encoder(void* arg)
+{
+	PIP_Encoder* encoder = (PIP_Encoder*) arg;
+
+	for (uint i = 0; i < encoder->num_parts; i++) {
+		size_t offset = i * encoder->part_len;
+		size_t len = encoder->image->len - offset;
+		uint16_t crc;
+
+		if (len > encoder->part_len) {
+			len = encoder->part_len;
+		}
+
+		pthread_mutex_lock(&encoder->lock);
+		while (!encoder->stop
+				&& i - encoder->num_consumed >= PIP_ENCODER_DEPTH) {
+			pthread_cond_wait(&encoder->cond, &encoder->lock);
+		}
+		if (encoder->stop) {
+			pthread_mutex_unlock(&encoder->lock);
+			break;
+		}
+		pthread_mutex_unlock(&encoder->lock);
+
+		crc = encoder->crc_func(i, &encoder->image->data[offset], len,
+				encoder->context);
+
+		pthread_mutex_lock(&encoder->lock);
+		encoder->crcs[i % PIP_ENCODER_DEPTH] = crc;
+		encoder->num_produced = i + 1;
+		pthread_cond_broadcast(&encoder->cond);
+		pthread_mutex_unlock(&encoder->lock);
+	}
+
+	return NULL;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#ifndef PTLIB_PIP_PIP_ENCODER_H_
+#define PTLIB_PIP_PIP_ENCODER_H_
+
+#include "../logging.h"
+#include <pthread.h>
+#include <stdint.h>
+#include "../base64.h"
+
+#define PIP_ENCODER_DEPTH 32
+
+/*
+ * Returns the CRC of the whole command that carries the given part of the
+ * image, header included.
+ */
+typedef uint16_t (*PIP_Part_CRC_Func)(uint index, const uint8_t* data,
+		size_t len, void* context);
+
+/*
+ * Called each time the device acknowledges a command that carries a part of
+ * an image, with the number of image bytes acknowledged so far.
+ */
+typedef void (*PIP_Write_Progress_Func)(size_t acked_len, void* context);
+
+/*
+ * Calculates the CRCs of the commands that carry an image on a worker thread,
+ * up to PIP_ENCODER_DEPTH commands ahead of the sender. The sender has to take
+ * the CRCs in order with get_pip_encoder_crc().
+ *
+ * Commands are laid out in place in the image (see pip_overlay.h), which
+ * writes over the first bytes of the next part. A CRC is therefore only handed
+ * out once the CRC of the next part has been calculated too, so the worker
+ * never reads a part of the image while a command is laid out next to it.
+ */
+typedef struct {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	bool running;
+	bool stop;
+	const ByteData* image;
+	size_t part_len;
+	uint num_parts;
+	uint num_produced;
+	uint num_consumed;
+	PIP_Part_CRC_Func crc_func;
+	void* context;
+	uint16_t crcs[PIP_ENCODER_DEPTH];
+} PIP_Encoder;
+
+extern bool get_pip_encoder_crc(PIP_Encoder* encoder, uint index,
+		uint16_t* crc);
+extern int start_pip_encoder(PIP_Encoder* encoder, const ByteData* image,
+		size_t part_len, PIP_Part_CRC_Func crc_func, void* context);
+extern void stop_pip_encoder(PIP_Encoder* encoder);
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#include "pip_overlay.h"
+
+void close_pip_overlay(PIP_Overlay* overlay)
+{
+	if (overlay->head == NULL) {
+		return;
+	}
+
+	memcpy(overlay->head, overlay->saved_head, overlay->head_len);
+	memcpy(overlay->tail, overlay->saved_tail, overlay->tail_len);
+	overlay->head = NULL;
+	overlay->tail = NULL;
+}
+
+/*
+ * Returns false when the part of the image does not have enough image bytes
+ * around it for the header and footer, which is always the case for the first
+ * and last parts. The caller then has to build the command in its own buffer.
+ */
+bool open_pip_overlay(PIP_Overlay* overlay, ByteData* image,
+		size_t offset, size_t len, size_t head_len, size_t tail_len,
+		ReportData* cmd)
+{
+	overlay->head = NULL;
+	overlay->tail = NULL;
+
+	if (head_len > PIP_OVERLAY_MAX_HEAD_LEN
+			|| tail_len > PIP_OVERLAY_MAX_TAIL_LEN
+			|| offset < head_len
+			|| offset + len + tail_len > image->len
+			|| head_len + len + tail_len > cmd->max_len) {
+		return false;
+	}
+
+	overlay->head = &image->data[offset - head_len];
+	overlay->tail = &image->data[offset + len];
+	overlay->head_len = head_len;
+	overlay->tail_len = tail_len;
+	memcpy(overlay->saved_head, overlay->head, head_len);
+	memcpy(overlay->saved_tail, overlay->tail, tail_len);
+
+	cmd->data = overlay->head;
+	return true;
+}
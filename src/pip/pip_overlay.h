@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#ifndef PTLIB_PIP_PIP_OVERLAY_H_
+#define PTLIB_PIP_PIP_OVERLAY_H_
+
+#include "../logging.h"
+#include <stdint.h>
+#include "../base64.h"
+#include "../report_data.h"
+
+#define PIP_OVERLAY_MAX_HEAD_LEN 8
+#define PIP_OVERLAY_MAX_TAIL_LEN 2
+
+/*
+ * Lays a command out in place around a part of an image, so that the image
+ * bytes are sent without being copied. The bytes of the image that the command
+ * header and footer are written over are saved, and they have to be put back
+ * with close_pip_overlay() once the command has been sent and before the
+ * neighbouring part of the image is used.
+ */
+typedef struct {
+	uint8_t* head;
+	uint8_t* tail;
+	size_t head_len;
+	size_t tail_len;
+	uint8_t saved_head[PIP_OVERLAY_MAX_HEAD_LEN];
+	uint8_t saved_tail[PIP_OVERLAY_MAX_TAIL_LEN];
+} PIP_Overlay;
+
+extern void close_pip_overlay(PIP_Overlay* overlay);
+extern bool open_pip_overlay(PIP_Overlay* overlay, ByteData* image,
+		size_t offset, size_t len, size_t head_len, size_t tail_len,
+		ReportData* cmd);
+
+#endif
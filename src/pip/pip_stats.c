@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#include "pip_stats.h"
+
+typedef struct {
+	uint64_t count;
+	uint64_t timeouts;
+	uint64_t retries;
+	long double send_ms;
+	long double wait_ms;
+	long double reassembly_ms;
+	long double min_ms;
+	long double max_ms;
+	uint64_t buckets[PIP_STATS_NUM_BUCKETS];
+} PIP_Cmd_Stats;
+
+typedef struct {
+	uint64_t arena_allocs;
+	uint64_t heap_allocs;
+	size_t arena_peak;
+} PIP_Buffer_Stats;
+
+static char* PIP_PROTOCOL_NAMES[] = {
+		[PIP_PROTOCOL_PIP2] = "PIP2",
+		[PIP_PROTOCOL_PIP3] = "PIP3"
+};
+
+static PIP_Cmd_Stats pip2_cmd_stats[NUM_PIP2_CMD_IDS];
+static PIP_Cmd_Stats pip3_cmd_stats[NUM_PIP3_CMD_IDS];
+static PIP_Buffer_Stats buffer_stats[NUM_PIP_PROTOCOLS];
+
+static PIP_Cmd_Stats* _get_cmd_stats(PIP_Protocol protocol, uint8_t cmd_id);
+static char* _get_cmd_name(PIP_Protocol protocol, uint8_t cmd_id);
+static uint _get_latency_bucket(long double latency_ms);
+static long double _get_latency_percentile(const PIP_Cmd_Stats* stats,
+		uint percentile);
+static void _print_cmd_stats_json(FILE* stream, PIP_Protocol protocol);
+static void _print_cmd_stats_text(FILE* stream, PIP_Protocol protocol);
+
+void print_pip_stats(FILE* stream, PIP_Stats_Format format)
+{
+	switch (format) {
+	case PIP_STATS_FORMAT_TEXT:
+		for (int i = 0; i < NUM_PIP_PROTOCOLS; i++) {
+			_print_cmd_stats_text(stream, (PIP_Protocol) i);
+		}
+		for (int i = 0; i < NUM_PIP_PROTOCOLS; i++) {
+			if (buffer_stats[i].arena_allocs + buffer_stats[i].heap_allocs
+					== 0) {
+				continue;
+			}
+			fprintf(stream,
+					"%s buffers: %llu from the session arena (%lu bytes at "
+					"peak), %llu from the heap.\n",
+					PIP_PROTOCOL_NAMES[i],
+					(unsigned long long) buffer_stats[i].arena_allocs,
+					buffer_stats[i].arena_peak,
+					(unsigned long long) buffer_stats[i].heap_allocs);
+		}
+		break;
+	case PIP_STATS_FORMAT_JSON:
+		fprintf(stream, "{");
+		for (int i = 0; i < NUM_PIP_PROTOCOLS; i++) {
+			fprintf(stream, "%s\"%s\": [", (i == 0) ? "" : ", ",
+					PIP_PROTOCOL_NAMES[i]);
+			_print_cmd_stats_json(stream, (PIP_Protocol) i);
+			fprintf(stream, "]");
+		}
+		fprintf(stream, ", \"buffers\": {");
+		for (int i = 0; i < NUM_PIP_PROTOCOLS; i++) {
+			fprintf(stream,
+					"%s\"%s\": {\"arena\": %llu, \"heap\": %llu, "
+					"\"arena_peak_bytes\": %lu}",
+					(i == 0) ? "" : ", ", PIP_PROTOCOL_NAMES[i],
+					(unsigned long long) buffer_stats[i].arena_allocs,
+					(unsigned long long) buffer_stats[i].heap_allocs,
+					buffer_stats[i].arena_peak);
+		}
+		fprintf(stream, "}}\n");
+		break;
+	default:
+		break;
+	}
+}
+
+void record_pip_buffer_alloc(PIP_Protocol protocol, bool from_heap,
+		size_t arena_used)
+{
+	PIP_Buffer_Stats* stats = &buffer_stats[protocol];
+
+	if (from_heap) {
+		stats->heap_allocs++;
+	} else {
+		stats->arena_allocs++;
+	}
+	if (arena_used > stats->arena_peak) {
+		stats->arena_peak = arena_used;
+	}
+}
+
+void record_pip_cmd(PIP_Protocol protocol, uint8_t cmd_id,
+		long double send_ms, long double wait_ms, long double reassembly_ms,
+		bool timed_out)
+{
+	PIP_Cmd_Stats* stats = _get_cmd_stats(protocol, cmd_id);
+	if (stats == NULL) {
+		return;
+	}
+
+	if (timed_out) {
+		stats->timeouts++;
+		return;
+	}
+
+	long double latency_ms = send_ms + wait_ms + reassembly_ms;
+	if (stats->count == 0 || latency_ms < stats->min_ms) {
+		stats->min_ms = latency_ms;
+	}
+	if (stats->count == 0 || latency_ms > stats->max_ms) {
+		stats->max_ms = latency_ms;
+	}
+	stats->count++;
+	stats->send_ms += send_ms;
+	stats->wait_ms += wait_ms;
+	stats->reassembly_ms += reassembly_ms;
+	stats->buckets[_get_latency_bucket(latency_ms)]++;
+}
+
+void record_pip_cmd_retries(PIP_Protocol protocol, uint8_t cmd_id,
+		uint retries)
+{
+	PIP_Cmd_Stats* stats = _get_cmd_stats(protocol, cmd_id);
+	if (stats != NULL) {
+		stats->retries += retries;
+	}
+}
+
+void reset_pip_stats()
+{
+	memset(pip2_cmd_stats, 0, sizeof(pip2_cmd_stats));
+	memset(pip3_cmd_stats, 0, sizeof(pip3_cmd_stats));
+	memset(buffer_stats, 0, sizeof(buffer_stats));
+}
+
+static PIP_Cmd_Stats* _get_cmd_stats(PIP_Protocol protocol, uint8_t cmd_id)
+{
+	if (protocol == PIP_PROTOCOL_PIP2 && cmd_id < NUM_PIP2_CMD_IDS) {
+		return &pip2_cmd_stats[cmd_id];
+	} else if (protocol == PIP_PROTOCOL_PIP3 && cmd_id < NUM_PIP3_CMD_IDS) {
+		return &pip3_cmd_stats[cmd_id];
+	}
+
+	return NULL;
+}
+
+static char* _get_cmd_name(PIP_Protocol protocol, uint8_t cmd_id)
+{
+	char* name = NULL;
+
+	if (protocol == PIP_PROTOCOL_PIP2) {
+		name = PIP2_CMD_NAMES[cmd_id];
+	} else {
+		name = PIP3_CMD_NAMES[cmd_id];
+	}
+
+	return (name != NULL) ? name : "Unknown";
+}
+
+static uint _get_latency_bucket(long double latency_ms)
+{
+	uint64_t latency_us = (latency_ms > 0) ? (uint64_t) (latency_ms * 1e3L) : 0;
+	uint bucket = 0;
+
+	while (latency_us > 1 && bucket < PIP_STATS_NUM_BUCKETS - 1) {
+		latency_us >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+/*
+ * Returns the upper bound of the bucket holding the given percentile, capped
+ * by the largest latency seen.
+ */
+static long double _get_latency_percentile(const PIP_Cmd_Stats* stats,
+		uint percentile)
+{
+	uint64_t target = (stats->count * percentile + 99) / 100;
+	uint64_t seen = 0;
+
+	for (uint i = 0; i < PIP_STATS_NUM_BUCKETS; i++) {
+		seen += stats->buckets[i];
+		if (seen >= target) {
+			long double upper_ms = (long double) (2ULL << i) / 1e3L;
+			return (upper_ms < stats->max_ms) ? upper_ms : stats->max_ms;
+		}
+	}
+
+	return stats->max_ms;
+}
+
+static void _print_cmd_stats_json(FILE* stream, PIP_Protocol protocol)
+{
+	uint num_cmd_ids = (protocol == PIP_PROTOCOL_PIP2)
+			? NUM_PIP2_CMD_IDS : NUM_PIP3_CMD_IDS;
+	bool first = true;
+
+	for (uint id = 0; id < num_cmd_ids; id++) {
+		const PIP_Cmd_Stats* stats = _get_cmd_stats(protocol, id);
+		if (stats->count == 0 && stats->timeouts == 0 && stats->retries == 0) {
+			continue;
+		}
+
+		long double count = (stats->count > 0) ? stats->count : 1;
+		fprintf(stream,
+				"%s{\"cmd\": \"%s\", \"id\": %u, \"count\": %llu, "
+				"\"timeouts\": %llu, \"retries\": %llu, "
+				"\"avg_send_ms\": %.3Lf, \"avg_wait_ms\": %.3Lf, "
+				"\"avg_reassembly_ms\": %.3Lf, \"min_ms\": %.3Lf, "
+				"\"p50_ms\": %.3Lf, \"p90_ms\": %.3Lf, \"p99_ms\": %.3Lf, "
+				"\"max_ms\": %.3Lf, \"histogram_us\": [",
+				first ? "" : ", ", _get_cmd_name(protocol, id), id,
+				(unsigned long long) stats->count,
+				(unsigned long long) stats->timeouts,
+				(unsigned long long) stats->retries,
+				stats->send_ms / count, stats->wait_ms / count,
+				stats->reassembly_ms / count, stats->min_ms,
+				_get_latency_percentile(stats, 50),
+				_get_latency_percentile(stats, 90),
+				_get_latency_percentile(stats, 99), stats->max_ms);
+		first = false;
+
+		bool first_bucket = true;
+		for (uint i = 0; i < PIP_STATS_NUM_BUCKETS; i++) {
+			if (stats->buckets[i] == 0) {
+				continue;
+			}
+			fprintf(stream, "%s{\"lt\": %llu, \"count\": %llu}",
+					first_bucket ? "" : ", ", 2ULL << i,
+					(unsigned long long) stats->buckets[i]);
+			first_bucket = false;
+		}
+		fprintf(stream, "]}");
+	}
+}
+
+static void _print_cmd_stats_text(FILE* stream, PIP_Protocol protocol)
+{
+	uint num_cmd_ids = (protocol == PIP_PROTOCOL_PIP2)
+			? NUM_PIP2_CMD_IDS : NUM_PIP3_CMD_IDS;
+	bool header_printed = false;
+
+	for (uint id = 0; id < num_cmd_ids; id++) {
+		const PIP_Cmd_Stats* stats = _get_cmd_stats(protocol, id);
+		if (stats->count == 0 && stats->timeouts == 0 && stats->retries == 0) {
+			continue;
+		}
+
+		if (!header_printed) {
+			fprintf(stream,
+					"%s command latency (ms):\n"
+					"%-24s %8s %8s %8s %10s %10s %10s %10s %10s %10s %10s "
+					"%10s\n",
+					PIP_PROTOCOL_NAMES[protocol], "Command", "Count",
+					"Timeouts", "Retries", "Send", "Wait", "Reassembly",
+					"Min", "P50", "P90", "P99", "Max");
+			header_printed = true;
+		}
+
+		long double count = (stats->count > 0) ? stats->count : 1;
+		fprintf(stream,
+				"%-24s %8llu %8llu %8llu %10.3Lf %10.3Lf %10.3Lf %10.3Lf "
+				"%10.3Lf %10.3Lf %10.3Lf %10.3Lf\n",
+				_get_cmd_name(protocol, id),
+				(unsigned long long) stats->count,
+				(unsigned long long) stats->timeouts,
+				(unsigned long long) stats->retries,
+				stats->send_ms / count, stats->wait_ms / count,
+				stats->reassembly_ms / count, stats->min_ms,
+				_get_latency_percentile(stats, 50),
+				_get_latency_percentile(stats, 90),
+				_get_latency_percentile(stats, 99), stats->max_ms);
+	}
+}
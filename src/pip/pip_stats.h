@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#ifndef PTLIB_PIP_PIP_STATS_H_
+#define PTLIB_PIP_PIP_STATS_H_
+
+#include "../logging.h"
+#include <stdint.h>
+#include "pip2_cmd_id.h"
+#include "pip3_cmd_id.h"
+
+/*
+ * Bucket N counts the latencies from 2^N up to 2^(N+1) microseconds. The last
+ * bucket also counts everything above it.
+ */
+#define PIP_STATS_NUM_BUCKETS 24
+
+typedef enum {
+	PIP_PROTOCOL_PIP2,
+	PIP_PROTOCOL_PIP3,
+	NUM_PIP_PROTOCOLS
+} PIP_Protocol;
+
+typedef enum {
+	PIP_STATS_FORMAT_NONE,
+	PIP_STATS_FORMAT_TEXT,
+	PIP_STATS_FORMAT_JSON
+} PIP_Stats_Format;
+
+extern void print_pip_stats(FILE* stream, PIP_Stats_Format format);
+extern void record_pip_buffer_alloc(PIP_Protocol protocol, bool from_heap,
+		size_t arena_used);
+extern void record_pip_cmd(PIP_Protocol protocol, uint8_t cmd_id,
+		long double send_ms, long double wait_ms, long double reassembly_ms,
+		bool timed_out);
+extern void record_pip_cmd_retries(PIP_Protocol protocol, uint8_t cmd_id,
+		uint retries);
+extern void reset_pip_stats();
+
+#endif
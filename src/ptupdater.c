@@ -1,7 +1,9 @@
 /*
  * Copyright (c) Parade Technologies, Ltd. 2023.
  */
+#include <ctype.h>
 #include <getopt.h>
+#include <sys/resource.h>
 #include "dut_utils/dut_utils.h"
 #include "fw_version.h"
 #include "hid/hidraw.h"
@@ -11,19 +13,39 @@
 #define FLAG_NOT_SET 0
 
 #define I2C_ADDR 0x24
+#define PARADE_VENDOR_ID 0x1DA0
+
+#define CHECK_ACTIVE_REPORT_BUFFER_DEPTH 16
 
 typedef struct {
 	bool check_active;
 	bool check_target;
 	bool update;
+	char* dump_flash_file;
+	uint8_t flash_file_num;
 	char* hidraw_sysfs_node_file;
 	char* ptu_file;
 	bool use_i2c_dev;
 	int i2c_bus;
 	int i2c_addr;
+	uint report_buffer_depth;
+	int vendor_id;
+	int product_id;
+	bool use_detect_cache;
+	bool use_io_uring;
+	int rt_priority;
+	int cpu_affinity;
+	bool lock_memory;
+	uint write_window;
+	bool use_fixed_cmd_delay;
+	bool use_diff_write;
+	bool use_resume;
+	PIP_Stats_Format stats_format;
 } PtUpdater_Config;
 
 static void _parse_args(int argc, char **argv, PtUpdater_Config* config);
+static unsigned long _parse_ulong_arg(const char* option, const char* arg,
+		int base, unsigned long min_value, unsigned long max_value);
 static void _print_help();
 static int _run(const PtUpdater_Config* config);
 static int _setup(const PtUpdater_Config* config);
@@ -36,12 +58,30 @@ int main(int argc, char **argv)
 		.check_active = false,
 		.check_target = false,
 		.update = false,
+		.dump_flash_file = NULL,
+		.flash_file_num = PRIMARY_FW_BIN_FILE_NUM,
 		.hidraw_sysfs_node_file = NULL,
 		.ptu_file = NULL,
 		.use_i2c_dev = false,
 		.i2c_bus = 0,
 		.i2c_addr = I2C_ADDR,
+		.report_buffer_depth = 0,
+		.vendor_id = PARADE_VENDOR_ID,
+		.product_id = HID_PRODUCT_ID_ANY,
+		.use_detect_cache = true,
+		.use_io_uring = false,
+		.rt_priority = SCHED_RT_PRIORITY_NONE,
+		.cpu_affinity = SCHED_CPU_ANY,
+		.lock_memory = false,
+		.write_window = 1,
+		.use_fixed_cmd_delay = false,
+		.use_diff_write = false,
+		.use_resume = true,
+		.stats_format = PIP_STATS_FORMAT_NONE,
 	};
+	struct timespec setup_start_time;
+	struct timespec setup_end_time;
+	struct rusage usage;
 
 	if (argc == 1) {
 		_print_help();
@@ -66,16 +106,13 @@ int main(int argc, char **argv)
 	 */
 	_parse_args(argc, argv, &config);
 
-	if (config.hidraw_sysfs_node_file == NULL) {
-		output(FATAL,
-			"Must provide the HIDRAW node path as the first argument.\n");
-		exit(EXIT_FAILURE);
-		/* NOTREACHED */
+	if (config.hidraw_sysfs_node_file != NULL) {
+		output(DEBUG, "HIDRAW sysfs node filepath: '%s'.\n",
+			config.hidraw_sysfs_node_file);
+	} else {
+		output(DEBUG, "HIDRAW sysfs node will be auto-detected.\n");
 	}
 
-	output(DEBUG, "HIDRAW sysfs node filepath: '%s'.\n",
-		config.hidraw_sysfs_node_file);
-
 	/*
 	 * Act On Arguments
 	 * ========================================================================
@@ -93,14 +130,27 @@ int main(int argc, char **argv)
      * the DUT. So unless the '--check-active' and/or '--update' options, there
 	 * is no need to initialize the HIDRAW and PIP3 APIs.
 	 */
-	if ((config.check_active || config.update)
-			&& EXIT_SUCCESS != _setup(&config)) {
-		exit(EXIT_FAILURE);
-		/* NOTREACHED */
+	if (config.check_active || config.update
+			|| config.dump_flash_file != NULL) {
+		clock_gettime(CLOCK_MONOTONIC, &setup_start_time);
+		if (EXIT_SUCCESS != _setup(&config)) {
+			exit(EXIT_FAILURE);
+			/* NOTREACHED */
+		}
+		clock_gettime(CLOCK_MONOTONIC, &setup_end_time);
+		output(DEBUG, "Setup completed in %.3Lf ms.\n",
+				((setup_end_time.tv_sec - setup_start_time.tv_sec) * 1e3L
+				+ (setup_end_time.tv_nsec - setup_start_time.tv_nsec) / 1e6L));
 	}
 
 	rc = _run(&config);
 
+	print_pip_stats(stdout, config.stats_format);
+
+	if (0 == getrusage(RUSAGE_SELF, &usage)) {
+		output(DEBUG, "Peak RSS: %ld KiB.\n", usage.ru_maxrss);
+	}
+
 	exit(rc);
 }
 
@@ -174,6 +224,39 @@ RETURN:
 	return rc;
 }
 
+/*
+ * Parses the whole of 'arg' as an unsigned number from 'min_value' to
+ * 'max_value', and exits with an error naming 'option' when it is not.
+ */
+static unsigned long _parse_ulong_arg(const char* option, const char* arg,
+		int base, unsigned long min_value, unsigned long max_value)
+{
+	char* end = NULL;
+	unsigned long value;
+
+	errno = 0;
+	value = strtoul(arg, &end, base);
+	if (!(base == 16 ? isxdigit((unsigned char) arg[0])
+				: isdigit((unsigned char) arg[0]))
+			|| *end != '\0' || errno != 0
+			|| value < min_value || value > max_value) {
+		_print_help();
+		if (base == 16) {
+			output(FATAL, "Invalid '--%s' value '%s'. Expected a hexadecimal "
+					"number from 0x%lX to 0x%lX.\n", option, arg, min_value,
+					max_value);
+		} else {
+			output(FATAL, "Invalid '--%s' value '%s'. Expected a decimal "
+					"number from %lu to %lu.\n", option, arg, min_value,
+					max_value);
+		}
+		exit(EXIT_FAILURE);
+		/* NOTREACHED */
+	}
+
+	return value;
+}
+
 static void _parse_args(int argc, char **argv, PtUpdater_Config* config)
 {
 	bool help_flag = false;
@@ -198,6 +281,12 @@ static void _parse_args(int argc, char **argv, PtUpdater_Config* config)
 			 * forms the next section must be used.
 			 */
 			{"check-active", no_argument, 0, },
+			{"diff-write",   no_argument, 0, },
+			{"fixed-cmd-delay", no_argument, 0, },
+			{"io-uring",     no_argument, 0, },
+			{"mlock",        no_argument, 0, },
+			{"no-detect-cache", no_argument, 0, },
+			{"no-resume",    no_argument, 0, },
 			{"version",      no_argument, 0, },
 
 			/*
@@ -212,9 +301,23 @@ static void _parse_args(int argc, char **argv, PtUpdater_Config* config)
 			 * Options requiring arguments.
 			 */
 			{"check-target", required_argument, 0, },
+			{"cpu-affinity", required_argument, 0, },
+			{"dump-flash",   required_argument, 0, },
+			{"flash-file",   required_argument, 0, },
 			{"i2c-bus",      required_argument, 0, },
+			{"pid",          required_argument, 0, },
+			{"report-buffer-depth", required_argument, 0, },
+			{"rt-priority",  required_argument, 0, },
 			{"update", 	     required_argument, 0, },
 			{"verbose",      required_argument, 0, },
+			{"vid",          required_argument, 0, },
+			{"write-window", required_argument, 0, },
+
+			/*
+			 * Options with an optional argument, which has to be given as
+			 * '--option=ARG'.
+			 */
+			{"stats",        optional_argument, 0, },
 	
 			/*
 			 * getopt_long requires this structure to be terminated
@@ -237,16 +340,97 @@ static void _parse_args(int argc, char **argv, PtUpdater_Config* config)
 			if (strcmp(long_options[option_index].name, "check-active") == 0) {
 				config->check_active = true;
 				output(DEBUG, "option --check-active\n");
+			} else if (strcmp(long_options[option_index].name, "cpu-affinity")
+					== 0) {
+				config->cpu_affinity = (int) _parse_ulong_arg(
+						"cpu-affinity", optarg, 10, 0, CPU_SETSIZE - 1);
+				output(DEBUG, "option --cpu-affinity %d\n",
+						config->cpu_affinity);
+			} else if (strcmp(long_options[option_index].name, "diff-write")
+					== 0) {
+				config->use_diff_write = true;
+				output(DEBUG, "option --diff-write\n");
+			} else if (strcmp(long_options[option_index].name, "dump-flash")
+					== 0) {
+				config->dump_flash_file = optarg;
+				output(DEBUG, "option --dump-flash %s\n",
+						config->dump_flash_file);
+			} else if (strcmp(long_options[option_index].name,
+					"fixed-cmd-delay") == 0) {
+				config->use_fixed_cmd_delay = true;
+				output(DEBUG, "option --fixed-cmd-delay\n");
+			} else if (strcmp(long_options[option_index].name, "flash-file")
+					== 0) {
+				config->flash_file_num = (uint8_t) _parse_ulong_arg(
+						"flash-file", optarg, 10, 0, UINT8_MAX);
+				output(DEBUG, "option --flash-file %u\n",
+						config->flash_file_num);
 			} else if (strcmp(long_options[option_index].name, "i2c-bus")
 					== 0) {
 				config->use_i2c_dev = true;
 				config->i2c_bus = (int) strtol(optarg, NULL, 10);
 				output(DEBUG, "option --i2c-bus %d\n", config->i2c_bus);
+			} else if (strcmp(long_options[option_index].name, "io-uring")
+					== 0) {
+				config->use_io_uring = true;
+				output(DEBUG, "option --io-uring\n");
+			} else if (strcmp(long_options[option_index].name, "mlock") == 0) {
+				config->lock_memory = true;
+				output(DEBUG, "option --mlock\n");
+			} else if (strcmp(long_options[option_index].name,
+					"no-detect-cache") == 0) {
+				config->use_detect_cache = false;
+				output(DEBUG, "option --no-detect-cache\n");
+			} else if (strcmp(long_options[option_index].name, "no-resume")
+					== 0) {
+				config->use_resume = false;
+				output(DEBUG, "option --no-resume\n");
+			} else if (strcmp(long_options[option_index].name, "pid") == 0) {
+				config->product_id = (int) _parse_ulong_arg("pid", optarg,
+						16, 0, 0xFFFF);
+				output(DEBUG, "option --pid 0x%04X\n", config->product_id);
+			} else if (strcmp(long_options[option_index].name, "vid") == 0) {
+				config->vendor_id = (int) _parse_ulong_arg("vid", optarg,
+						16, 0, 0xFFFF);
+				output(DEBUG, "option --vid 0x%04X\n", config->vendor_id);
+			} else if (strcmp(long_options[option_index].name, "write-window")
+					== 0) {
+				config->write_window = (uint) _parse_ulong_arg(
+						"write-window", optarg, 10, 1,
+						PIP3_FILE_WRITE_MAX_WINDOW);
+				output(DEBUG, "option --write-window %u\n",
+						config->write_window);
 			} else if (strcmp(long_options[option_index].name, "check-target")
 					== 0) {
 				config->check_target = true;
 				config->ptu_file = optarg;
 				output(DEBUG, "option --check-target %s\n", config->ptu_file);
+			} else if (strcmp(long_options[option_index].name,
+					"report-buffer-depth") == 0) {
+				config->report_buffer_depth = (uint) _parse_ulong_arg(
+						"report-buffer-depth", optarg, 10, 1,
+						HIDRAW_REPORT_BUFFER_MAX_DEPTH);
+				output(DEBUG, "option --report-buffer-depth %u\n",
+						config->report_buffer_depth);
+			} else if (strcmp(long_options[option_index].name, "rt-priority")
+					== 0) {
+				int max_priority = sched_get_priority_max(SCHED_FIFO);
+				config->rt_priority = (int) _parse_ulong_arg("rt-priority",
+						optarg, 10, 0, (max_priority > 0) ? max_priority : 0);
+				output(DEBUG, "option --rt-priority %d\n", config->rt_priority);
+			} else if (strcmp(long_options[option_index].name, "stats") == 0) {
+				if (optarg == NULL || strcmp(optarg, "text") == 0) {
+					config->stats_format = PIP_STATS_FORMAT_TEXT;
+				} else if (strcmp(optarg, "json") == 0) {
+					config->stats_format = PIP_STATS_FORMAT_JSON;
+				} else {
+					_print_help();
+					output(FATAL, "Unknown '--stats' format '%s'.\n", optarg);
+					exit(EXIT_FAILURE);
+					/* NOTREACHED */
+				}
+				output(DEBUG, "option --stats %s\n",
+						(optarg == NULL) ? "text" : optarg);
 			} else if (strcmp(long_options[option_index].name, "update") == 0) {
 				config->update = true;
 				config->ptu_file = optarg;
@@ -333,7 +517,8 @@ static void _parse_args(int argc, char **argv, PtUpdater_Config* config)
 		/* NOTREACHED */
 	}
 
-	if (!config->check_active && !config->check_target && !config->update) {
+	if (!config->check_active && !config->check_target && !config->update
+			&& config->dump_flash_file == NULL) {
 		_print_help();
 		exit(EXIT_FAILURE);
 		/* NOTREACHED */
@@ -346,7 +531,7 @@ static void _print_help()
 "ptupdater %s, a Parade Technologies Touch Firmware Updater tool\n",
 		SW_VERSION);
 	fprintf(stderr,
-"Usage: ptupdater <hidraw/sysfs/node/filepath> [options]\n\n");
+"Usage: ptupdater [hidraw/sysfs/node/filepath] [options]\n\n");
 	fprintf(stderr,
 "Overview:\n"
 "  Parade Technologies Touch Firmware Updater command line tool that checks\n"
@@ -368,12 +553,71 @@ static void _print_help()
 "                                version by parsing the header of the binary\n"
 "                                image embedded in the PTU file.\n"
 "\n"
+"       --cpu-affinity CPU       Pin the HID report reader thread to the\n"
+"                                given CPU.\n"
+"\n"
+"       --diff-write             With '--update', read the firmware flash\n"
+"                                file back first and only rewrite the parts\n"
+"                                that differ, instead of erasing and\n"
+"                                rewriting the whole file. Falls back to a\n"
+"                                full rewrite if that fails.\n"
+"\n"
+"       --dump-flash   FILEPATH  Read the whole flash file selected by\n"
+"                                '--flash-file' back from the touch processor\n"
+"                                and save it to FILEPATH.\n"
+"\n"
+"       --fixed-cmd-delay        Wait a fixed delay after sending each PIP2\n"
+"                                and PIP3 command before reading its response\n"
+"                                instead of reading the response as soon as\n"
+"                                it is available. For compatibility with\n"
+"                                devices that need the extra time.\n"
+"\n"
+"       --flash-file   FILE_NUM  The flash file read by '--dump-flash', e.g.\n"
+"                                1 for the primary firmware, 3 for the\n"
+"                                configuration or 5 for the calibration\n"
+"                                data. Defaults to 1.\n"
+"\n"
 "       --i2c-bus      I2C-BUS   The I2C bus of the Parade touch device,\n"
 "                                which is required for using PIP2\n"
 "                                ROM-Bootloader interface. Therefore, if this\n"
 "                                argument is not provided, then the Secondary\n"
 "                                Loader Image will certainly not be updated.\n"
 "\n"
+"       --io-uring               Read and write HID reports through io_uring\n"
+"                                instead of epoll and write(2). Falls back to\n"
+"                                the default transport when the kernel does\n"
+"                                not support io_uring.\n"
+"\n"
+"       --mlock                  Lock the process memory so that page faults\n"
+"                                cannot delay the handling of HID reports.\n"
+"                                Requires CAP_IPC_LOCK or a large enough\n"
+"                                RLIMIT_MEMLOCK.\n"
+"\n"
+"       --no-detect-cache        Do not use or update the cached result of\n"
+"                                HIDRAW node auto-detection.\n"
+"\n"
+"       --no-resume              Always erase and rewrite a flash file from\n"
+"                                the start, instead of resuming an update of\n"
+"                                the same image that was interrupted.\n"
+"\n"
+"       --pid          PID       Hexadecimal product ID used to auto-detect\n"
+"                                the HIDRAW node when its path is not given.\n"
+"                                By default any product ID matches.\n"
+"\n"
+"       --report-buffer-depth DEPTH\n"
+"                                Number of HID input reports that can be\n"
+"                                buffered while waiting to be processed.\n"
+"                                Rounded up to a power of two. Defaults to\n"
+"                                16 for '--check-active' and 256 otherwise.\n"
+"\n"
+"       --rt-priority  PRIORITY  Run the HID report reader thread with the\n"
+"                                given SCHED_FIFO priority (1-99). Requires\n"
+"                                CAP_SYS_NICE or a large enough RLIMIT_RTPRIO.\n"
+"\n"
+"       --stats[=FORMAT]         Print per-command PIP2/PIP3 latency\n"
+"                                histograms, timeouts and retries on exit.\n"
+"                                FORMAT is 'text' (default) or 'json'.\n"
+"\n"
 "       --update       FILEPATH  Check the active firmware version running on\n"
 "                                the touch processor, and update it if it\n"
 "                                does not match the target firmware version.\n"
@@ -399,12 +643,24 @@ static void _print_help()
 "       --version                Prints the ptupdater tool version number and\n"
 "                                then exits.\n"
 "\n"
+"       --write-window COUNT     Maximum number of PIP3 FILE_WRITE commands\n"
+"                                that can be outstanding at once (1-8). The\n"
+"                                window grows up to this count while the\n"
+"                                device keeps up and is halved on failure.\n"
+"                                Defaults to 1.\n"
+"\n"
+"       --vid          VID       Hexadecimal vendor ID used to auto-detect\n"
+"                                the HIDRAW node when its path is not given.\n"
+"                                Defaults to 1DA0 (Parade Technologies).\n"
+"\n"
 "Examples:\n"
 "\n"
 "  ptupdater /dev/hidraw0 --update /lib/firmware/parade.ptu\n"
 "\n"
 "  ptupdater /dev/hidraw0 --check-active\n"
 "\n"
+"  ptupdater --check-active --pid 3406\n"
+"\n"
 "  ptupdater /dev/hidraw0 --check-target /lib/firmware/parade.ptu\n"
 "\n"
 "\n"
@@ -425,6 +681,58 @@ static const ByteData flash_files_to_erase = {
 	.len = sizeof(flash_files_to_erase_id_list)/sizeof(flash_files_to_erase_id_list[0]),
 };
 
+static int dump_flash_file(const char* file, uint8_t file_num)
+{
+	Flash_Loader_Options loader_options = {
+		.list = {
+			FLASH_LOADER_TP_PROGRAMMER_IMAGE,
+			FLASH_LOADER_PIP2_ROM_BL,
+			FLASH_LOADER_NONE
+		}
+	};
+	char tmp_file[PATH_MAX];
+	int rc = EXIT_FAILURE;
+	int fd;
+
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	/*
+	 * The flash file is saved next to the output file first, so that a failed
+	 * read does not clobber an earlier copy.
+	 */
+	if (snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", file)
+			>= sizeof(tmp_file)) {
+		output(ERROR, "%s: The file path is too long: %s.\n", __func__, file);
+		return EXIT_FAILURE;
+	}
+
+	fd = open(tmp_file, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		output(ERROR, "%s: Could not open file=%s. %s [%d].\n",
+				__func__, tmp_file, strerror(errno), errno);
+		return EXIT_FAILURE;
+	}
+
+	rc = read_dut_flash_file(file_num, fd, &loader_options);
+
+	if (close(fd) != 0) {
+		output(ERROR, "%s: Failed to close file=%s. %s [%d].\n",
+				__func__, tmp_file, strerror(errno), errno);
+		rc = EXIT_FAILURE;
+	}
+
+	if (rc == EXIT_SUCCESS && rename(tmp_file, file) != 0) {
+		output(ERROR, "%s: Failed to rename %s to %s. %s [%d].\n",
+				__func__, tmp_file, file, strerror(errno), errno);
+		rc = EXIT_FAILURE;
+	}
+
+	if (rc != EXIT_SUCCESS) {
+		unlink(tmp_file);
+	}
+	return rc;
+}
+
 static int process_fw_file(const char* file, bool update_fw)
 {
 	FILE* fptr = NULL;
@@ -557,6 +865,13 @@ static int _run(const PtUpdater_Config* config)
 		goto END;
 	}
 
+	if (config->dump_flash_file != NULL
+			&& EXIT_SUCCESS != dump_flash_file(config->dump_flash_file,
+					config->flash_file_num)) {
+		rc = EXIT_FAILURE;
+		goto END;
+	}
+
 	rc = EXIT_SUCCESS;
 
 END:
@@ -591,12 +906,28 @@ static int _setup(const PtUpdater_Config* config)
 		hid_desc_ptr = &hid_desc;
 	}
 
-	if (EXIT_SUCCESS != init_hidraw_api(config->hidraw_sysfs_node_file,
-			hid_desc_ptr)) {
+	char detected_sysfs_node_file[PATH_MAX];
+	const char* sysfs_node_file = config->hidraw_sysfs_node_file;
+	if (sysfs_node_file == NULL) {
+		if (EXIT_SUCCESS != auto_detect_hidraw_sysfs_node(config->vendor_id,
+				config->product_id, config->use_detect_cache,
+				detected_sysfs_node_file, sizeof(detected_sysfs_node_file))) {
+			return EXIT_FAILURE;
+			/* NOTREACHED */
+		}
+		sysfs_node_file = detected_sysfs_node_file;
+	}
+
+	if (EXIT_SUCCESS != init_hidraw_api(sysfs_node_file, hid_desc_ptr)) {
 		return EXIT_FAILURE;
 		/* NOTREACHED */
 	}
 
+	set_pip2_fixed_cmd_delay(config->use_fixed_cmd_delay);
+	set_pip3_fixed_cmd_delay(config->use_fixed_cmd_delay);
+	set_dut_flash_diff_write(config->use_diff_write);
+	set_dut_flash_resume(config->use_resume);
+
 	if (config->use_i2c_dev) {
 		if (EXIT_SUCCESS != setup_pip2_api(CHANNEL_TYPE_I2CDEV, config->i2c_bus,
 				config->i2c_addr)) {
@@ -609,7 +940,33 @@ static int _setup(const PtUpdater_Config* config)
 			"specified.\n");
 	}
 
-	if (EXIT_SUCCESS != setup_pip3_api(&hidraw_channel,
+	uint report_buffer_depth = config->report_buffer_depth;
+	if (report_buffer_depth == 0) {
+		report_buffer_depth = (config->update
+				? HIDRAW_REPORT_BUFFER_DEFAULT_DEPTH
+				: CHECK_ACTIVE_REPORT_BUFFER_DEPTH);
+	}
+	if (EXIT_SUCCESS != set_hidraw_report_buffer_depth(report_buffer_depth)) {
+		return EXIT_FAILURE;
+		/* NOTREACHED */
+	}
+
+	/*
+	 * The scheduling options only affect latency, so the update carries on
+	 * without them when the required privileges are missing.
+	 */
+	if (config->lock_memory) {
+		lock_process_memory();
+	}
+	set_hidraw_report_reader_sched(config->rt_priority, config->cpu_affinity);
+
+	if (EXIT_SUCCESS != set_pip3_file_write_window(config->write_window)) {
+		return EXIT_FAILURE;
+		/* NOTREACHED */
+	}
+
+	if (EXIT_SUCCESS != setup_pip3_api(
+			(config->use_io_uring ? &hidraw_uring_channel : &hidraw_channel),
 			HID_REPORT_ID_SOLICITED_RESPONSE)) {
 		if (is_pip2_api_active()) {
 			output(WARNING,
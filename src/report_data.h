@@ -49,6 +49,7 @@ typedef struct {
 	size_t index;
 	size_t num_records;
 	size_t max_len;
+	struct timespec timestamp;
 } ReportData;
 
 typedef struct {
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#include "ptlib_sched.h"
+
+int lock_process_memory()
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+
+	if (0 != mlockall(MCL_CURRENT | MCL_FUTURE)) {
+		output(WARNING,
+				"Failed to lock the process memory, page faults may delay "
+				"report processing. %s [%d]\n", strerror(errno), errno);
+		return EXIT_FAILURE;
+	}
+
+	output(DEBUG, "Process memory locked.\n");
+	return EXIT_SUCCESS;
+}
+
+int set_thread_cpu_affinity(pthread_t thread, int cpu)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	cpu_set_t cpu_set;
+
+	if (cpu < 0 || cpu >= CPU_SETSIZE) {
+		output(WARNING, "Invalid CPU (%d) for the thread affinity.\n", cpu);
+		return EXIT_FAILURE;
+	}
+
+	CPU_ZERO(&cpu_set);
+	CPU_SET(cpu, &cpu_set);
+
+	int rc = pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set);
+	if (rc != 0) {
+		output(WARNING, "Failed to pin the thread to CPU %d. %s [%d]\n", cpu,
+				strerror(rc), rc);
+		return EXIT_FAILURE;
+	}
+
+	output(DEBUG, "Thread pinned to CPU %d.\n", cpu);
+	return EXIT_SUCCESS;
+}
+
+int set_thread_rt_priority(pthread_t thread, int priority)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	struct sched_param param = { .sched_priority = priority };
+	int min_priority = sched_get_priority_min(SCHED_FIFO);
+	int max_priority = sched_get_priority_max(SCHED_FIFO);
+
+	if (priority < min_priority || priority > max_priority) {
+		output(WARNING,
+				"The SCHED_FIFO priority must be between %d and %d (%d was "
+				"given).\n", min_priority, max_priority, priority);
+		return EXIT_FAILURE;
+	}
+
+	int rc = pthread_setschedparam(thread, SCHED_FIFO, &param);
+	if (rc != 0) {
+		output(WARNING,
+				"Failed to set the SCHED_FIFO priority %d%s. %s [%d]\n",
+				priority,
+				(rc == EPERM) ? " (CAP_SYS_NICE or RLIMIT_RTPRIO is required)"
+						: "",
+				strerror(rc), rc);
+		return EXIT_FAILURE;
+	}
+
+	output(DEBUG, "Thread scheduled with SCHED_FIFO priority %d.\n", priority);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#ifndef _PTLIB_SCHED_H
+#define _PTLIB_SCHED_H
+
+#include "../logging.h"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#define SCHED_RT_PRIORITY_NONE 0
+#define SCHED_CPU_ANY -1
+
+extern int lock_process_memory();
+extern int set_thread_cpu_affinity(pthread_t thread, int cpu);
+extern int set_thread_rt_priority(pthread_t thread, int priority);
+
+#endif
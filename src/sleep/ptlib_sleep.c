@@ -32,6 +32,27 @@ void sleep_us (unsigned int us){
 	_sleep_ns(time_requested);
 }
 
+void get_monotonic_deadline(struct timespec* deadline, long double timeout_val)
+{
+	long sec = (long) timeout_val;
+	long nsec = (long) ((timeout_val - sec) * NSEC_SEC_RATIO);
+
+	clock_gettime(CLOCK_MONOTONIC, deadline);
+	deadline->tv_sec += sec;
+	deadline->tv_nsec += nsec;
+	if (deadline->tv_nsec >= (long) NSEC_SEC_RATIO) {
+		deadline->tv_sec++;
+		deadline->tv_nsec -= (long) NSEC_SEC_RATIO;
+	}
+}
+
+long double get_timespec_diff_ms(const struct timespec* start,
+		const struct timespec* end)
+{
+	return ((end->tv_sec - start->tv_sec) * 1e3L
+			+ (end->tv_nsec - start->tv_nsec) / 1e6L);
+}
+
 bool time_limit_reached(const struct timeval* start, long double limit)
 {
 	struct timeval now;
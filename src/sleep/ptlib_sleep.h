@@ -9,11 +9,16 @@
 #include "../logging.h"
 
 #define USEC_SEC_RATIO (long double) 1e6
+#define NSEC_SEC_RATIO (long double) 1e9
 
 typedef unsigned char uint8_t;
 
 extern void sleep_ms (unsigned int ms);
 extern void sleep_us (unsigned int us);
+extern void get_monotonic_deadline(struct timespec* deadline,
+		long double timeout_val);
+extern long double get_timespec_diff_ms(const struct timespec* start,
+		const struct timespec* end);
 extern bool time_limit_reached(const struct timeval* start, long double limit);
 
 #endif 
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#include "ptlib_uring.h"
+
+void exit_uring(PtUring* ring)
+{
+	if (ring->sqes != NULL && ring->sqes != MAP_FAILED) {
+		munmap(ring->sqes, ring->sqes_size);
+	}
+	if (ring->cq_ring_ptr != NULL && ring->cq_ring_ptr != MAP_FAILED
+			&& ring->cq_ring_ptr != ring->sq_ring_ptr) {
+		munmap(ring->cq_ring_ptr, ring->cq_ring_size);
+	}
+	if (ring->sq_ring_ptr != NULL && ring->sq_ring_ptr != MAP_FAILED) {
+		munmap(ring->sq_ring_ptr, ring->sq_ring_size);
+	}
+	if (ring->fd >= 0) {
+		close(ring->fd);
+	}
+
+	memset(ring, 0, sizeof(PtUring));
+	ring->fd = -1;
+}
+
+struct io_uring_sqe* get_uring_sqe(PtUring* ring)
+{
+	uint32_t tail = *ring->sq_tail + ring->sq_pending;
+
+	if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE)
+			> *ring->sq_mask) {
+		return NULL;
+	}
+
+	uint32_t index = tail & *ring->sq_mask;
+	struct io_uring_sqe* sqe = &ring->sqes[index];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	ring->sq_array[index] = index;
+	ring->sq_pending++;
+
+	return sqe;
+}
+
+int init_uring(PtUring* ring, uint32_t entries)
+{
+	output(DEBUG, "%s: Starting.\n", __func__);
+	struct io_uring_params params;
+
+	memset(ring, 0, sizeof(PtUring));
+	memset(&params, 0, sizeof(params));
+
+	ring->fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+	if (ring->fd < 0) {
+		output(DEBUG, "%s: io_uring_setup failed. %s [%d]\n", __func__,
+				strerror(errno), errno);
+		ring->fd = -1;
+		return EXIT_FAILURE;
+	}
+	ring->features = params.features;
+
+	ring->sq_ring_size = params.sq_off.array
+			+ params.sq_entries * sizeof(uint32_t);
+	ring->cq_ring_size = params.cq_off.cqes
+			+ params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_ring_size > ring->sq_ring_size) {
+			ring->sq_ring_size = ring->cq_ring_size;
+		}
+		ring->cq_ring_size = ring->sq_ring_size;
+	}
+
+	ring->sq_ring_ptr = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ring->sq_ring_ptr == MAP_FAILED) {
+		goto ERROR;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_ring_ptr = ring->sq_ring_ptr;
+	} else {
+		ring->cq_ring_ptr = mmap(NULL, ring->cq_ring_size,
+				PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+				IORING_OFF_CQ_RING);
+		if (ring->cq_ring_ptr == MAP_FAILED) {
+			goto ERROR;
+		}
+	}
+
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		goto ERROR;
+	}
+
+	uint8_t* sq_ring = (uint8_t*) ring->sq_ring_ptr;
+	ring->sq_head  = (uint32_t*) (sq_ring + params.sq_off.head);
+	ring->sq_tail  = (uint32_t*) (sq_ring + params.sq_off.tail);
+	ring->sq_mask  = (uint32_t*) (sq_ring + params.sq_off.ring_mask);
+	ring->sq_array = (uint32_t*) (sq_ring + params.sq_off.array);
+
+	uint8_t* cq_ring = (uint8_t*) ring->cq_ring_ptr;
+	ring->cq_head = (uint32_t*) (cq_ring + params.cq_off.head);
+	ring->cq_tail = (uint32_t*) (cq_ring + params.cq_off.tail);
+	ring->cq_mask = (uint32_t*) (cq_ring + params.cq_off.ring_mask);
+	ring->cqes    = (struct io_uring_cqe*) (cq_ring + params.cq_off.cqes);
+
+	return EXIT_SUCCESS;
+
+ERROR:
+	output(DEBUG, "%s: Failed to map the io_uring rings. %s [%d]\n", __func__,
+			strerror(errno), errno);
+	exit_uring(ring);
+	return EXIT_FAILURE;
+}
+
+struct io_uring_cqe* peek_uring_cqe(PtUring* ring)
+{
+	uint32_t head = *ring->cq_head;
+
+	if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+		return NULL;
+	}
+
+	return &ring->cqes[head & *ring->cq_mask];
+}
+
+void prep_uring_rw(struct io_uring_sqe* sqe, uint8_t opcode, int fd,
+		void* buf, uint32_t len, uint64_t user_data)
+{
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->off = (uint64_t) -1;
+	sqe->addr = (uint64_t) (uintptr_t) buf;
+	sqe->len = len;
+	sqe->user_data = user_data;
+}
+
+void seen_uring_cqe(PtUring* ring)
+{
+	__atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+int submit_uring(PtUring* ring, uint32_t min_complete)
+{
+	uint32_t to_submit = ring->sq_pending;
+	int rc;
+
+	__atomic_store_n(ring->sq_tail, *ring->sq_tail + to_submit,
+			__ATOMIC_RELEASE);
+	ring->sq_pending = 0;
+
+	do {
+		rc = (int) syscall(__NR_io_uring_enter, ring->fd, to_submit,
+				min_complete, (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0,
+				NULL, 0);
+	} while (rc < 0 && errno == EINTR);
+
+	return rc;
+}
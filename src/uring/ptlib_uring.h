@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Parade Technologies, Ltd. 2023.
+ */
+
+#ifndef _PTLIB_URING_H
+#define _PTLIB_URING_H
+
+#include <linux/io_uring.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "../logging.h"
+
+/*
+ * Minimal io_uring wrapper built directly on the io_uring_setup(2) and
+ * io_uring_enter(2) system calls, so that liburing is not required.
+ */
+typedef struct {
+	int fd;
+	uint32_t features;
+
+	uint32_t* sq_head;
+	uint32_t* sq_tail;
+	uint32_t* sq_mask;
+	uint32_t* sq_array;
+	struct io_uring_sqe* sqes;
+	uint32_t sq_pending;
+
+	uint32_t* cq_head;
+	uint32_t* cq_tail;
+	uint32_t* cq_mask;
+	struct io_uring_cqe* cqes;
+
+	void*  sq_ring_ptr;
+	size_t sq_ring_size;
+	void*  cq_ring_ptr;
+	size_t cq_ring_size;
+	size_t sqes_size;
+} PtUring;
+
+extern void exit_uring(PtUring* ring);
+extern struct io_uring_sqe* get_uring_sqe(PtUring* ring);
+extern int init_uring(PtUring* ring, uint32_t entries);
+extern struct io_uring_cqe* peek_uring_cqe(PtUring* ring);
+extern void prep_uring_rw(struct io_uring_sqe* sqe, uint8_t opcode, int fd,
+		void* buf, uint32_t len, uint64_t user_data);
+extern void seen_uring_cqe(PtUring* ring);
+extern int submit_uring(PtUring* ring, uint32_t min_complete);
+
+#endif